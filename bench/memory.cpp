@@ -0,0 +1,71 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+#include <hayai/hayai.hpp>
+#include <hayai/hayai_posix_main.cpp>
+#include <hemingway/table.hpp>
+#include <hemingway/memory.hpp>
+
+using namespace lsh;
+
+generator g(128);
+
+std::vector<vector> vs = vector::random_batch(128, 200000, g);
+
+/**
+ * Get the resident set size of this process. Memory freed by earlier runs is
+ * reused by later ones, so run each benchmark on its own, for example using
+ * `-f memory.build_arena`, for the sizes to be comparable.
+ *
+ * @return The number of bytes resident in memory.
+ */
+std::size_t rss() {
+  std::ifstream f("/proc/self/statm");
+
+  std::size_t total = 0;
+  std::size_t resident = 0;
+
+  f >> total >> resident;
+
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * Build a table of many small buckets from a resource and print how much the
+ * resident set grew.
+ */
+void build(memory_resource* r) {
+  std::size_t m = rss();
+
+  table t({.dimensions = 128, .samples = 16, .partitions = 32, .seed = 1, .resource = r});
+
+  t.insert_batch(vs.data(), vs.size(), 1);
+
+  std::cout << "                          ";
+  std::cout << "RSS: " << (rss() - m) / (1024.0 * 1024.0) << " MiB" << std::endl;
+}
+
+BENCHMARK(memory, build_heap, 5, 1) {
+  build(nullptr);
+}
+
+BENCHMARK(memory, build_arena, 5, 1) {
+  arena a;
+
+  build(&a);
+}
+
+BENCHMARK(memory, build_huge_pages, 5, 1) {
+  huge_pages h;
+
+  build(&h);
+}
+
+BENCHMARK(memory, build_arena_huge_pages, 5, 1) {
+  huge_pages h;
+  arena a(huge_pages::page, &h);
+
+  build(&a);
+}
@@ -2,10 +2,14 @@
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
 #include <hayai/hayai.hpp>
 #include <hayai/hayai_posix_main.cpp>
 #include <hemingway/vector.hpp>
 #include <hemingway/table.hpp>
+#include <hemingway/tuner.hpp>
 
 using namespace lsh;
 
@@ -20,20 +24,12 @@ std::vector<vector> parse(std::string path) {
 
     int read = stream.gcount();
 
-    for (int i = 0; i < read; i += 8) {
-      unsigned long n;
+    for (int i = 0; i + 8 <= read; i += 8) {
+      kernel::word w;
 
-      for (int j = 0; j < 8; j++) {
-        ((char*) &n)[j] = buffer[i + j];
-      }
-
-      std::vector<bool> c(64);
-
-      for (int j = 0; j < 64; j++) {
-          c[j] = (n >> (63 - j)) & 1;
-      }
+      std::memcpy(&w, &buffer[i], sizeof(w));
 
-      vectors.push_back(vector(c));
+      vectors.push_back(vector(&w, 64));
     }
   }
 
@@ -55,6 +51,14 @@ table t_lin(table::brute({.dimensions = 64}));
 table t_cla({.dimensions = 64, .samples = k, .partitions = l});
 table t_cov({.dimensions = 64, .radius = r});
 
+// Multi-probing a quarter of the partitions, probing every bucket one sampled
+// bit away from the bucket of the query.
+table t_mpr({.dimensions = 64, .samples = k, .partitions = (unsigned short) (l / 4), .probes = k});
+
+// The cheapest configuration the tuner finds on a sample of the vectors that
+// meets the same recall target as the classic table.
+table t_tun = tuner(std::vector<vector>(vs.begin(), vs.begin() + std::min<std::size_t>(vs.size(), 10000)), r, 1 - delta).tune();
+
 unsigned int vn = vs.size();
 unsigned int qn = qs.size();
 
@@ -75,6 +79,11 @@ void print_stats(const table& t) {
   std::cout << "Number of vectors: ";
   std::cout << s.vectors / (1.0 * s.buckets);
   std::cout << " /bucket" << std::endl;
+
+  std::cout << "               ";
+  std::cout << "Memory: ";
+  std::cout << s.memory / (1024.0 * 1024.0);
+  std::cout << " MiB" << std::endl;
 }
 
 void print_results(const std::vector<vector>& fs) {
@@ -115,6 +124,26 @@ BENCHMARK(table, insert_classic, runs, vn / runs) {
   }
 }
 
+BENCHMARK(table, insert_multiprobe, runs, vn / runs) {
+  unsigned int i = vi++ % vn;
+
+  t_mpr.insert(vs[i]);
+
+  if (i == vn - 1) {
+    print_stats(t_mpr);
+  }
+}
+
+BENCHMARK(table, insert_tuned, runs, vn / runs) {
+  unsigned int i = vi++ % vn;
+
+  t_tun.insert(vs[i]);
+
+  if (i == vn - 1) {
+    print_stats(t_tun);
+  }
+}
+
 BENCHMARK(table, insert_covering, runs, vn / runs) {
   unsigned int i = vi++ % vn;
 
@@ -149,6 +178,36 @@ BENCHMARK(table, query_classic, runs, qn / runs) {
   }
 }
 
+std::vector<vector> vf_mpr;
+
+BENCHMARK(table, query_multiprobe, runs, qn / runs) {
+  unsigned int i = qi++ % qn;
+
+  vector q = qs[i];
+  vector t = gt[i];
+
+  vf_mpr.push_back(t_mpr.query(q));
+
+  if (i == qn - 1) {
+    print_results(vf_mpr);
+  }
+}
+
+std::vector<vector> vf_tun;
+
+BENCHMARK(table, query_tuned, runs, qn / runs) {
+  unsigned int i = qi++ % qn;
+
+  vector q = qs[i];
+  vector t = gt[i];
+
+  vf_tun.push_back(t_tun.query(q));
+
+  if (i == qn - 1) {
+    print_results(vf_tun);
+  }
+}
+
 std::vector<vector> vf_cov;
 
 BENCHMARK(table, query_covering, runs, qn / runs) {
@@ -163,3 +222,38 @@ BENCHMARK(table, query_covering, runs, qn / runs) {
     print_results(vf_cov);
   }
 }
+
+std::vector<table::result> rs(qn);
+
+unsigned int bi;
+
+double bt;
+
+void print_throughput(double seconds) {
+  std::cout << "                      ";
+  std::cout << "Throughput: ";
+  std::cout << qn / seconds;
+  std::cout << " queries/second" << std::endl;
+}
+
+BENCHMARK_P(table, query_batch_covering, 10, 1, (unsigned int threads)) {
+  pool p(threads);
+
+  auto start = std::chrono::steady_clock::now();
+
+  t_cov.query_batch(qs.data(), qn, rs.data(), p);
+
+  bt += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  if (++bi % 10 == 0) {
+    print_throughput(bt / 10);
+
+    bt = 0;
+  }
+}
+
+BENCHMARK_P_INSTANCE(table, query_batch_covering, (1));
+BENCHMARK_P_INSTANCE(table, query_batch_covering, (2));
+BENCHMARK_P_INSTANCE(table, query_batch_covering, (4));
+BENCHMARK_P_INSTANCE(table, query_batch_covering, (8));
+BENCHMARK_P_INSTANCE(table, query_batch_covering, (16));
@@ -0,0 +1,307 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <hayai/hayai.hpp>
+#include <hayai/hayai_main.hpp>
+#include <hemingway/vector.hpp>
+#include <hemingway/table.hpp>
+
+using namespace lsh;
+
+/**
+ * The number of queries run against each configuration.
+ */
+const unsigned int queries = 1000;
+
+/**
+ * A set of random vectors, along with queries close to some of them and the
+ * distance from each query to its true nearest neighbour.
+ */
+struct dataset {
+  std::vector<vector> vectors;
+  std::vector<vector> queries;
+  std::vector<unsigned int> nearest;
+};
+
+/**
+ * The metrics measured for a single configuration.
+ */
+struct metrics {
+  double build;
+  std::size_t memory;
+  double qps;
+  double p50;
+  double p99;
+  double recall;
+};
+
+/**
+ * The metrics of the configuration that was measured last, picked up by the
+ * outputter once hayai finishes the benchmark.
+ */
+metrics last;
+
+/**
+ * Get the dataset of a given number of vectors of a given dimensionality,
+ * generating it and its ground truth on first use. Queries are dataset vectors
+ * with d/16 random bits flipped.
+ */
+const dataset& data(unsigned int d, unsigned int n) {
+  static std::map<std::pair<unsigned int, unsigned int>, std::unique_ptr<dataset>> cache;
+
+  std::unique_ptr<dataset>& s = cache[std::make_pair(d, n)];
+
+  if (s) {
+    return *s;
+  }
+
+  s.reset(new dataset());
+
+  generator g(d * 31 + n);
+
+  s->vectors = vector::random_batch(d, n, g);
+
+  for (unsigned int i = 0; i < queries; i++) {
+    std::vector<bool> c(d);
+
+    const vector& v = s->vectors[g() % n];
+
+    for (unsigned int j = 0; j < d; j++) {
+      c[j] = v.get(j);
+    }
+
+    for (unsigned int j = 0; j < d / 16; j++) {
+      unsigned int k = g() % d;
+
+      c[k] = !c[k];
+    }
+
+    s->queries.push_back(vector(c));
+
+    unsigned int b = d;
+
+    for (const vector& u: s->vectors) {
+      b = std::min(b, vector::distance(s->queries.back(), u));
+    }
+
+    s->nearest.push_back(b);
+  }
+
+  return *s;
+}
+
+/**
+ * Build a table from a dataset and measure it, storing the metrics in `last`.
+ */
+void measure(table& t, const dataset& s) {
+  typedef std::chrono::steady_clock clock;
+
+  auto start = clock::now();
+
+  t.insert_batch(s.vectors.data(), s.vectors.size());
+
+  last.build = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+  last.memory = t.stats().memory;
+
+  std::vector<double> ls;
+
+  unsigned int hits = 0;
+
+  start = clock::now();
+
+  for (unsigned int i = 0; i < queries; i++) {
+    auto begin = clock::now();
+
+    table::result r = t.query_nearest(s.queries[i]);
+
+    ls.push_back(std::chrono::duration<double, std::micro>(clock::now() - begin).count());
+
+    hits += r.distance == s.nearest[i];
+  }
+
+  double total = std::chrono::duration<double>(clock::now() - start).count();
+
+  std::sort(ls.begin(), ls.end());
+
+  last.qps = queries / total;
+  last.p50 = ls[ls.size() / 2];
+  last.p99 = ls[ls.size() * 99 / 100];
+  last.recall = hits / (1.0 * queries);
+}
+
+/**
+ * Writes the metrics of each configuration as CSV or JSON, alongside the
+ * timing of the benchmark run by hayai.
+ */
+class recorder: public hayai::Outputter {
+  private:
+    std::ostream& stream_;
+
+    bool json_;
+
+    unsigned int rows_;
+
+  public:
+    recorder(std::ostream& stream, bool json): stream_(stream), json_(json), rows_(0) {}
+
+    void Begin(const std::size_t&, const std::size_t&) {
+      if (this->json_) {
+        this->stream_ << "[" << std::endl;
+      } else {
+        this->stream_ << "scheme,dimensions,size,samples,partitions,radius,";
+        this->stream_ << "build_ms,memory_bytes,qps,p50_us,p99_us,recall,run_ms" << std::endl;
+      }
+    }
+
+    void End(const std::size_t&, const std::size_t&) {
+      if (this->json_) {
+        this->stream_ << std::endl << "]" << std::endl;
+      }
+    }
+
+    void BeginTest(const std::string&, const std::string&, const hayai::TestParametersDescriptor&, const std::size_t&, const std::size_t&) {}
+
+    void SkipDisabledTest(const std::string&, const std::string&, const hayai::TestParametersDescriptor&, const std::size_t&, const std::size_t&) {}
+
+    void EndTest(const std::string&, const std::string& test, const hayai::TestParametersDescriptor& ps, const hayai::TestResult& r) {
+      std::map<std::string, std::string> p;
+
+      // Declarations read like `unsigned int dimensions`, so key the values
+      // by the last word of their declaration.
+      for (const hayai::TestParameterDescriptor& d: ps.Parameters()) {
+        p[d.Declaration.substr(d.Declaration.find_last_of(' ') + 1)] = d.Value;
+      }
+
+      const char* keys[] = {"dimensions", "size", "samples", "partitions", "radius"};
+
+      double run = r.RunTimeAverage() / 1e6;
+
+      if (this->json_) {
+        this->stream_ << (this->rows_++ ? ",\n" : "") << "  {\"scheme\": \"" << test << "\"";
+
+        for (const char* k: keys) {
+          if (p.count(k)) {
+            this->stream_ << ", \"" << k << "\": " << p[k];
+          }
+        }
+
+        this->stream_ << ", \"build_ms\": " << last.build;
+        this->stream_ << ", \"memory_bytes\": " << last.memory;
+        this->stream_ << ", \"qps\": " << last.qps;
+        this->stream_ << ", \"p50_us\": " << last.p50;
+        this->stream_ << ", \"p99_us\": " << last.p99;
+        this->stream_ << ", \"recall\": " << last.recall;
+        this->stream_ << ", \"run_ms\": " << run << "}";
+      } else {
+        this->stream_ << test;
+
+        for (const char* k: keys) {
+          this->stream_ << "," << (p.count(k) ? p[k] : "");
+        }
+
+        this->stream_ << "," << last.build << "," << last.memory << "," << last.qps;
+        this->stream_ << "," << last.p50 << "," << last.p99 << "," << last.recall;
+        this->stream_ << "," << run << std::endl;
+      }
+    }
+};
+
+BENCHMARK_P(sweep, brute, 1, 1, (unsigned int dimensions, unsigned int size)) {
+  table t(table::brute({.dimensions = dimensions}));
+
+  measure(t, data(dimensions, size));
+}
+
+BENCHMARK_P(sweep, classic, 1, 1, (unsigned int dimensions, unsigned int size, unsigned short samples, unsigned short partitions)) {
+  table t({.dimensions = dimensions, .samples = samples, .partitions = partitions});
+
+  measure(t, data(dimensions, size));
+}
+
+BENCHMARK_P(sweep, covering, 1, 1, (unsigned int dimensions, unsigned int size, unsigned short radius)) {
+  table t({.dimensions = dimensions, .radius = radius});
+
+  measure(t, data(dimensions, size));
+}
+
+BENCHMARK_P_INSTANCE(sweep, brute, (64, 10000));
+BENCHMARK_P_INSTANCE(sweep, brute, (128, 10000));
+BENCHMARK_P_INSTANCE(sweep, brute, (256, 10000));
+BENCHMARK_P_INSTANCE(sweep, brute, (64, 100000));
+
+BENCHMARK_P_INSTANCE(sweep, classic, (64, 10000, 16, 8));
+BENCHMARK_P_INSTANCE(sweep, classic, (64, 10000, 16, 32));
+BENCHMARK_P_INSTANCE(sweep, classic, (64, 10000, 24, 32));
+BENCHMARK_P_INSTANCE(sweep, classic, (64, 10000, 24, 64));
+BENCHMARK_P_INSTANCE(sweep, classic, (64, 100000, 24, 64));
+BENCHMARK_P_INSTANCE(sweep, classic, (128, 10000, 32, 32));
+BENCHMARK_P_INSTANCE(sweep, classic, (128, 10000, 32, 64));
+BENCHMARK_P_INSTANCE(sweep, classic, (256, 10000, 48, 64));
+
+BENCHMARK_P_INSTANCE(sweep, covering, (64, 10000, 2));
+BENCHMARK_P_INSTANCE(sweep, covering, (64, 10000, 4));
+BENCHMARK_P_INSTANCE(sweep, covering, (64, 100000, 4));
+BENCHMARK_P_INSTANCE(sweep, covering, (128, 10000, 4));
+BENCHMARK_P_INSTANCE(sweep, covering, (128, 10000, 6));
+BENCHMARK_P_INSTANCE(sweep, covering, (256, 10000, 6));
+
+/**
+ * Run the sweep. On top of the options of hayai, `--metrics <csv|json>:<path>`
+ * writes the metrics of every configuration to a file, and may be given more
+ * than once.
+ */
+int main(int argc, char** argv) {
+  hayai::MainRunner runner;
+
+  std::vector<char*> rest;
+
+  int result = runner.ParseArgs(argc, argv, &rest);
+
+  if (result) {
+    return result;
+  }
+
+  // Outputters must outlive the run, as hayai only keeps pointers to them.
+  std::vector<std::unique_ptr<std::ofstream>> files;
+  std::vector<std::unique_ptr<recorder>> outputs;
+
+  for (std::size_t i = 0; i < rest.size(); i++) {
+    if (std::strcmp(rest[i], "--metrics") != 0 || i + 1 == rest.size()) {
+      std::cerr << "Unknown option: " << rest[i] << std::endl;
+
+      return 1;
+    }
+
+    std::string a = rest[++i];
+    std::string::size_type c = a.find(':');
+
+    std::string format = a.substr(0, c);
+
+    if (c == std::string::npos || (format != "csv" && format != "json")) {
+      std::cerr << "Invalid metrics output: " << a << std::endl;
+
+      return 1;
+    }
+
+    files.emplace_back(new std::ofstream(a.substr(c + 1)));
+
+    if (!*files.back()) {
+      std::cerr << "Could not open metrics output: " << a << std::endl;
+
+      return 1;
+    }
+
+    outputs.emplace_back(new recorder(*files.back(), format == "json"));
+
+    hayai::Benchmarker::AddOutputter(*outputs.back());
+  }
+
+  return runner.Run();
+}
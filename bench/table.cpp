@@ -1,14 +1,29 @@
 // Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
 #include <vector>
+#include <thread>
+#include <atomic>
 #include <hayai/hayai.hpp>
 #include <hayai/hayai_posix_main.cpp>
 #include <hemingway/table.hpp>
+#include <hemingway/concurrent_table.hpp>
+#include <hemingway/sharded_table.hpp>
 
 using namespace lsh;
 
 table t_cla({.dimensions = 128, .samples = 32, .partitions = 64});
 table t_cov({.dimensions = 128, .radius = 5});
 
+table t_cla_frozen = t_cla;
+table t_cov_frozen = t_cov;
+
+std::vector<vector> random(unsigned int n) {
+  generator g(n);
+
+  return vector::random_batch(128, n, g);
+}
+
+std::vector<vector> vs = random(20000);
+
 BENCHMARK(table, table_classic, 500, 12) {
   table({.dimensions = 128, .samples = 32, .partitions = 64});
 }
@@ -32,3 +47,198 @@ BENCHMARK(table, query_classic, 1500, 14) {
 BENCHMARK(table, query_covering, 1500, 14) {
   t_cov.query(vector::random(128));
 }
+
+// Copies the filled tables before each run, such that only freezing the copies
+// is timed.
+class freeze: public ::hayai::Fixture {
+  public:
+    virtual void SetUp() {
+      t_cla_frozen = t_cla;
+      t_cov_frozen = t_cov;
+    }
+};
+
+BENCHMARK_F(freeze, classic, 1, 1) {
+  t_cla_frozen.freeze();
+}
+
+BENCHMARK_F(freeze, covering, 1, 1) {
+  t_cov_frozen.freeze();
+}
+
+BENCHMARK(table, query_classic_frozen, 1500, 14) {
+  t_cla_frozen.query(vector::random(128));
+}
+
+BENCHMARK(table, query_covering_frozen, 1500, 14) {
+  t_cov_frozen.query(vector::random(128));
+}
+
+// A table of wide vectors whose buckets hold many far away candidates, most of
+// which are rejected without computing their full distance.
+generator g_wide(4096);
+
+std::vector<vector> vs_wide = vector::random_batch(4096, 5000, g_wide);
+
+table t_wide = [] {
+  table t({.dimensions = 4096, .samples = 4, .partitions = 8});
+
+  t.insert_batch(vs_wide.data(), vs_wide.size());
+  t.freeze();
+
+  return t;
+}();
+
+BENCHMARK(table, query_wide_frozen, 100, 10) {
+  t_wide.query_nearest(vector::random(4096, g_wide));
+}
+
+BENCHMARK(table, query_wide_frozen_near, 100, 10) {
+  std::vector<kernel::word> ws(64);
+
+  const kernel::word* v = vector_view(vs_wide[g_wide.below(5000)]).data();
+
+  // Query a stored vector with every 64th bit flipped.
+  for (unsigned int i = 0; i < 64; i++) {
+    ws[i] = v[i] ^ 1;
+  }
+
+  t_wide.query_nearest(vector_view(ws.data(), 4096));
+}
+
+// A large frozen table whose buckets are small but scattered across far more
+// memory than fits in the cache, such that queries stall on finding them.
+std::vector<vector> vs_large = random(200000);
+
+table t_large = [] {
+  table t({.dimensions = 128, .samples = 20, .partitions = 32, .seed = 1});
+
+  t.insert_batch(vs_large.data(), vs_large.size());
+  t.freeze();
+
+  return t;
+}();
+
+std::vector<table::result> rs_large(1000);
+
+BENCHMARK(table, query_large_frozen, 10, 5) {
+  for (unsigned int i = 0; i < rs_large.size(); i++) {
+    rs_large[i] = t_large.query_nearest(vs[i]);
+  }
+}
+
+BENCHMARK(table, query_batch_large_frozen, 10, 5) {
+  t_large.query_batch(vs.data(), rs_large.size(), rs_large.data(), 1);
+}
+
+// The same kind of table with large buckets, frozen with and without
+// compressing the vector ids of its buckets.
+table t_dense({.dimensions = 128, .samples = 8, .partitions = 16, .seed = 1});
+
+table t_dense_compressed = [] {
+  t_dense.insert_batch(vs_large.data(), vs_large.size());
+
+  table t = t_dense;
+
+  t_dense.freeze();
+  t.freeze(true);
+
+  return t;
+}();
+
+BENCHMARK(table, query_dense_frozen, 10, 5) {
+  for (unsigned int i = 0; i < 100; i++) {
+    t_dense.query_nearest(vs[i]);
+  }
+}
+
+BENCHMARK(table, query_dense_compressed, 10, 5) {
+  for (unsigned int i = 0; i < 100; i++) {
+    t_dense_compressed.query_nearest(vs[i]);
+  }
+}
+
+BENCHMARK(table, insert_batch_classic, 10, 1) {
+  table t({.dimensions = 128, .samples = 32, .partitions = 64});
+
+  t.insert_batch(vs.data(), vs.size());
+}
+
+BENCHMARK(table, insert_batch_covering, 10, 1) {
+  table t({.dimensions = 128, .radius = 5});
+
+  t.insert_batch(vs.data(), vs.size());
+}
+
+BENCHMARK(table, query_k_covering, 1500, 14) {
+  t_cov.query_k(vector::random(128), 10);
+}
+
+BENCHMARK(table, query_any_covering, 1500, 14) {
+  t_cov.query_any(vector::random(128), 5);
+}
+
+unsigned int ei;
+
+BENCHMARK(table, erase_covering, 1500, 14) {
+  t_cov.erase(ei++);
+}
+
+concurrent_table t_con(table({.dimensions = 128, .radius = 5}));
+
+std::vector<unsigned int> is_con = t_con.insert_batch(vs.data(), vs.size());
+
+BENCHMARK_P(table, query_concurrent_covering, 5, 1, (unsigned int threads)) {
+  std::atomic<bool> done(false);
+
+  // A writer keeps inserting and erasing vectors while the readers query.
+  std::thread writer([&]() {
+    for (unsigned int i = 0; !done; i++) {
+      t_con.erase(t_con.insert(vs[i % vs.size()]));
+    }
+  });
+
+  std::vector<std::thread> readers;
+
+  for (unsigned int i = 0; i < threads; i++) {
+    readers.push_back(std::thread([&, i]() {
+      for (unsigned int j = 0; j < 20000 / threads; j++) {
+        t_con.query_nearest(vs[(i * 7919 + j) % vs.size()]);
+      }
+    }));
+  }
+
+  for (std::thread& r: readers) {
+    r.join();
+  }
+
+  done = true;
+
+  writer.join();
+}
+
+BENCHMARK_P_INSTANCE(table, query_concurrent_covering, (1));
+BENCHMARK_P_INSTANCE(table, query_concurrent_covering, (2));
+BENCHMARK_P_INSTANCE(table, query_concurrent_covering, (4));
+BENCHMARK_P_INSTANCE(table, query_concurrent_covering, (8));
+
+std::vector<table::result> rs_sha(vs.size());
+
+BENCHMARK_P(table, insert_batch_sharded, 10, 1, (unsigned int shards)) {
+  sharded_table t({.dimensions = 128, .radius = 5}, shards);
+
+  t.insert_batch(vs.data(), vs.size());
+}
+
+BENCHMARK_P_INSTANCE(table, insert_batch_sharded, (1));
+BENCHMARK_P_INSTANCE(table, insert_batch_sharded, (4));
+BENCHMARK_P_INSTANCE(table, insert_batch_sharded, (16));
+
+sharded_table t_sha({.dimensions = 128, .radius = 5}, 4);
+
+std::vector<unsigned int> is_sha = t_sha.insert_batch(vs.data(), vs.size());
+
+BENCHMARK(table, query_batch_sharded, 10, 1) {
+  t_sha.query_batch(vs.data(), vs.size(), rs_sha.data());
+}
+
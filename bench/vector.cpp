@@ -3,6 +3,7 @@
 #include <hayai/hayai.hpp>
 #include <hayai/hayai_posix_main.cpp>
 #include <hemingway/vector.hpp>
+#include <hemingway/basic_vector.hpp>
 
 using namespace lsh;
 
@@ -43,6 +44,181 @@ BENCHMARK(vector, distance, 10000, 6000) {
   vector::distance(u, v);
 }
 
-BENCHMARK(vector, random, 10000, 30) {
+BENCHMARK(vector, random, 10000, 6000) {
   vector::random(128);
 }
+
+generator g(1);
+
+BENCHMARK(vector, random_seeded, 10000, 6000) {
+  vector::random(128, g);
+}
+
+BENCHMARK(vector, random_batch, 100, 30) {
+  vector::random_batch(128, 1000, g);
+}
+
+vector u64 = vector::random(64);
+vector v64 = vector::random(64);
+vector u256 = vector::random(256);
+vector v256 = vector::random(256);
+
+basic_vector<64> bu64 = basic_vector<64>::random();
+basic_vector<64> bv64 = basic_vector<64>::random();
+basic_vector<128> bu128 = basic_vector<128>::random();
+basic_vector<128> bv128 = basic_vector<128>::random();
+basic_vector<256> bu256 = basic_vector<256>::random();
+basic_vector<256> bv256 = basic_vector<256>::random();
+
+BENCHMARK(fixed, distance_64, 10000, 6000) {
+  vector::distance(u64, v64);
+}
+
+BENCHMARK(fixed, basic_distance_64, 10000, 6000) {
+  basic_vector<64>::distance(bu64, bv64);
+}
+
+BENCHMARK(fixed, distance_128, 10000, 6000) {
+  vector::distance(u, v);
+}
+
+BENCHMARK(fixed, basic_distance_128, 10000, 6000) {
+  basic_vector<128>::distance(bu128, bv128);
+}
+
+BENCHMARK(fixed, distance_256, 10000, 6000) {
+  vector::distance(u256, v256);
+}
+
+BENCHMARK(fixed, basic_distance_256, 10000, 6000) {
+  basic_vector<256>::distance(bu256, bv256);
+}
+
+BENCHMARK(fixed, and_128, 10000, 600) {
+  v & u;
+}
+
+BENCHMARK(fixed, basic_and_128, 10000, 600) {
+  bv128 & bu128;
+}
+
+BENCHMARK(fixed, equals_128, 10000, 5500) {
+  void(v == u);
+}
+
+BENCHMARK(fixed, basic_equals_128, 10000, 5500) {
+  void(bv128 == bu128);
+}
+
+BENCHMARK(fixed, random_128, 10000, 6000) {
+  vector::random(128);
+}
+
+BENCHMARK(fixed, basic_random_128, 10000, 6000) {
+  basic_vector<128>::random();
+}
+
+kernel::word ku[64];
+kernel::word kv[64 * 16];
+unsigned int kd[16];
+
+// Select the kernels of an instruction set before each run rather than in the
+// timed body, skipping the runs of instruction sets that the host lacks.
+template <kernel::isa I>
+class kernels: public ::hayai::Fixture {
+  public:
+    bool supported;
+
+    virtual void SetUp() {
+      this->supported = kernel::supported(I);
+
+      if (this->supported) {
+        kernel::select(I);
+      }
+    }
+
+    virtual void TearDown() {
+      kernel::select(kernel::best());
+    }
+};
+
+typedef kernels<kernel::generic> kernel_generic;
+typedef kernels<kernel::popcnt> kernel_popcnt;
+typedef kernels<kernel::avx2> kernel_avx2;
+typedef kernels<kernel::avx512> kernel_avx512;
+
+BENCHMARK_P_F(kernel_generic, distance, 1000, 10000, (unsigned int bits)) {
+  kernel::distance(ku, kv, bits / 64);
+}
+
+BENCHMARK_P_F(kernel_popcnt, distance, 1000, 10000, (unsigned int bits)) {
+  if (this->supported) {
+    kernel::distance(ku, kv, bits / 64);
+  }
+}
+
+BENCHMARK_P_F(kernel_avx2, distance, 1000, 10000, (unsigned int bits)) {
+  if (this->supported) {
+    kernel::distance(ku, kv, bits / 64);
+  }
+}
+
+BENCHMARK_P_F(kernel_avx512, distance, 1000, 10000, (unsigned int bits)) {
+  if (this->supported) {
+    kernel::distance(ku, kv, bits / 64);
+  }
+}
+
+BENCHMARK_P_F(kernel_generic, distances, 1000, 1000, (unsigned int bits)) {
+  kernel::distance(ku, kv, bits / 64, 16, kd);
+}
+
+BENCHMARK_P_F(kernel_popcnt, distances, 1000, 1000, (unsigned int bits)) {
+  if (this->supported) {
+    kernel::distance(ku, kv, bits / 64, 16, kd);
+  }
+}
+
+BENCHMARK_P_F(kernel_avx2, distances, 1000, 1000, (unsigned int bits)) {
+  if (this->supported) {
+    kernel::distance(ku, kv, bits / 64, 16, kd);
+  }
+}
+
+BENCHMARK_P_F(kernel_avx512, distances, 1000, 1000, (unsigned int bits)) {
+  if (this->supported) {
+    kernel::distance(ku, kv, bits / 64, 16, kd);
+  }
+}
+
+BENCHMARK_P_INSTANCE(kernel_generic, distance, (64));
+BENCHMARK_P_INSTANCE(kernel_generic, distance, (256));
+BENCHMARK_P_INSTANCE(kernel_generic, distance, (1024));
+BENCHMARK_P_INSTANCE(kernel_generic, distance, (4096));
+
+BENCHMARK_P_INSTANCE(kernel_popcnt, distance, (64));
+BENCHMARK_P_INSTANCE(kernel_popcnt, distance, (256));
+BENCHMARK_P_INSTANCE(kernel_popcnt, distance, (1024));
+BENCHMARK_P_INSTANCE(kernel_popcnt, distance, (4096));
+
+BENCHMARK_P_INSTANCE(kernel_avx2, distance, (64));
+BENCHMARK_P_INSTANCE(kernel_avx2, distance, (256));
+BENCHMARK_P_INSTANCE(kernel_avx2, distance, (1024));
+BENCHMARK_P_INSTANCE(kernel_avx2, distance, (4096));
+
+BENCHMARK_P_INSTANCE(kernel_avx512, distance, (64));
+BENCHMARK_P_INSTANCE(kernel_avx512, distance, (256));
+BENCHMARK_P_INSTANCE(kernel_avx512, distance, (1024));
+BENCHMARK_P_INSTANCE(kernel_avx512, distance, (4096));
+
+BENCHMARK_P_INSTANCE(kernel_generic, distances, (64));
+BENCHMARK_P_INSTANCE(kernel_generic, distances, (1024));
+
+BENCHMARK_P_INSTANCE(kernel_popcnt, distances, (64));
+BENCHMARK_P_INSTANCE(kernel_popcnt, distances, (1024));
+
+BENCHMARK_P_INSTANCE(kernel_avx2, distances, (64));
+BENCHMARK_P_INSTANCE(kernel_avx2, distances, (1024));
+
+BENCHMARK_P_INSTANCE(kernel_avx512, distances, (64));
+BENCHMARK_P_INSTANCE(kernel_avx512, distances, (1024));
@@ -0,0 +1,507 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <hemingway/basic_vector.hpp>
+#include <hemingway/table.hpp>
+
+namespace lsh {
+  /**
+   * A lookup table of vectors whose number of components is fixed at compile
+   * time. Vectors are stored inline in the flat arena of the underlying
+   * `lsh::table`, and vectors of the wrong size are rejected at compile time
+   * rather than on every insert and query. Queries against vectors of up to
+   * `kernel::unrolled` chunks compare candidates using the unrolled kernels.
+   *
+   * @tparam Bits The number of components in vectors of the table.
+   */
+  template <unsigned int Bits>
+  class basic_table {
+    private:
+      /**
+       * The lookup table holding the vectors.
+       */
+      table table_;
+
+      /**
+       * The number of chunks that searches are specialized on, or 0 if the
+       * vectors are too long to be compared using the unrolled kernels.
+       */
+      static const unsigned int fixed = Bits / 64 <= kernel::unrolled ? Bits / 64 : 0;
+
+      /**
+       * Construct a new fixed-size lookup table from a lookup table of the
+       * same size.
+       *
+       * @param table The lookup table holding the vectors.
+       */
+      explicit basic_table(table&& table);
+
+    public:
+      struct classic {
+        /**
+         * The number of components to sample from vectors.
+         */
+        const unsigned short samples;
+
+        /**
+         * The number of partitions to use.
+         */
+        const unsigned short partitions;
+
+        /**
+         * The number of extra buckets to probe in each partition.
+         */
+        const unsigned int probes = 0;
+
+        /**
+         * The seed of the generator used to sample bits, drawn from a source
+         * of true randomness unless given.
+         */
+        const std::uint64_t seed = generator::entropy();
+
+        /**
+         * The memory resource to allocate the internals of the table from, or
+         * `nullptr` to use the heap.
+         */
+        memory_resource* const resource = nullptr;
+      };
+
+      struct covering {
+        /**
+         * The radius to cover.
+         */
+        const unsigned short radius;
+
+        /**
+         * The seed of the generator used to construct the basis, drawn from a
+         * source of true randomness unless given.
+         */
+        const std::uint64_t seed = generator::entropy();
+
+        /**
+         * The memory resource to allocate the internals of the table from, or
+         * `nullptr` to use the heap.
+         */
+        memory_resource* const resource = nullptr;
+      };
+
+      struct brute {
+        /**
+         * The memory resource to allocate the internals of the table from, or
+         * `nullptr` to use the heap.
+         */
+        memory_resource* const resource = nullptr;
+      };
+
+      /**
+       * Construct a new classic lookup table.
+       *
+       * @param config The configuration parameters for the lookup table.
+       */
+      basic_table(const classic& config);
+
+      /**
+       * Construct a new covering lookup table.
+       *
+       * @param config The configuration parameters for the lookup table.
+       */
+      basic_table(const covering& config);
+
+      /**
+       * Construct a brute-force lookup table.
+       *
+       * @param config The configuration parameters for the lookup table.
+       */
+      basic_table(const brute& config);
+
+      /**
+       * Get the number of vectors in this lookup table.
+       *
+       * @return The number of vectors in this lookup table.
+       */
+      unsigned int size() const;
+
+      /**
+       * Check if this lookup table has been frozen.
+       *
+       * @return `true` if this lookup table has been frozen, otherwise `false`.
+       */
+      bool frozen() const;
+
+      /**
+       * Freeze this lookup table, rewriting its partitions into compact arrays
+       * that are faster to query. A frozen table can no longer be modified.
+       *
+       * @param compress Whether or not to compress the vector ids of the buckets.
+       */
+      void freeze(bool compress = false);
+
+      /**
+       * Insert a vector into this lookup table.
+       *
+       * @param vector The vector to insert into this lookup table.
+       * @return The id of the vector, which stays the same until the vector is erased.
+       */
+      unsigned int insert(const basic_vector<Bits>& vector);
+
+      /**
+       * Insert a number of vectors into this lookup table using a number of
+       * worker threads.
+       *
+       * @param vectors The vectors to insert into this lookup table.
+       * @param n The number of vectors.
+       * @param threads The number of worker threads, or 0 to use one per hardware thread.
+       * @return The ids of the vectors, in the order they were given.
+       */
+      std::vector<unsigned int> insert_batch(const basic_vector<Bits>* vectors, std::size_t n, unsigned int threads = 0);
+
+      /**
+       * Erase a vector from this lookup table.
+       *
+       * @param vector The vector to erase from this lookup table.
+       * @return `true` if the vector was found and erased, otherwise `false`.
+       */
+      bool erase(const basic_vector<Bits>& vector);
+
+      /**
+       * Erase the vector with a given id from this lookup table.
+       *
+       * @param id The id of the vector to erase from this lookup table.
+       * @return `true` if the vector was found and erased, otherwise `false`.
+       */
+      bool erase(unsigned int id);
+
+      /**
+       * Query this lookup table for the id of and distance to the nearest
+       * neighbour of a query vector.
+       *
+       * @param vector The query vector to look up the nearest neighbour of.
+       * @return The nearest neighbour if found, otherwise a result with an id and distance of `UINT_MAX`.
+       */
+      table::result query_nearest(const basic_vector<Bits>& vector) const;
+
+      /**
+       * Query this lookup table for the k nearest neighbours of a query vector.
+       *
+       * @param vector The query vector to look up the nearest neighbours of.
+       * @param k The number of nearest neighbours to look up.
+       * @return Up to k nearest neighbours found, ordered by increasing distance.
+       */
+      std::vector<table::result> query_k(const basic_vector<Bits>& vector, unsigned int k) const;
+
+      /**
+       * Query this lookup table for the neighbours of a query vector within a
+       * given distance.
+       *
+       * @param vector The query vector to look up the neighbours of.
+       * @param radius The distance within which to look up neighbours.
+       * @return The neighbours found within the distance, ordered by increasing distance.
+       */
+      std::vector<table::result> query_radius(const basic_vector<Bits>& vector, unsigned int radius) const;
+
+      /**
+       * Query this lookup table for any neighbour of a query vector within a
+       * given distance, stopping as soon as one is found.
+       *
+       * @param vector The query vector to look up a neighbour of.
+       * @param radius The distance within which to look up a neighbour.
+       * @return The first neighbour found within the distance, otherwise the nearest neighbour found.
+       */
+      table::result query_any(const basic_vector<Bits>& vector, unsigned int radius) const;
+
+      /**
+       * Query this lookup table for the nearest neighbours of a number of
+       * query vectors, splitting the queries across the workers of a pool.
+       *
+       * @param vectors The query vectors to look up the nearest neighbours of.
+       * @param n The number of query vectors.
+       * @param results The array to write the result of each query to.
+       * @param pool The pool of workers to run the queries on.
+       */
+      void query_batch(const basic_vector<Bits>* vectors, std::size_t n, table::result* results, pool& pool) const;
+
+      /**
+       * Query this lookup table for the nearest neighbours of a number of
+       * query vectors using a number of worker threads.
+       *
+       * @param vectors The query vectors to look up the nearest neighbours of.
+       * @param n The number of query vectors.
+       * @param results The array to write the result of each query to.
+       * @param threads The number of worker threads, or 0 to use one per hardware thread.
+       */
+      void query_batch(const basic_vector<Bits>* vectors, std::size_t n, table::result* results, unsigned int threads = 0) const;
+
+      /**
+       * Save this lookup table to a file that can later be opened using
+       * `basic_table::open()` or `table::open()`.
+       *
+       * @param path The path of the file to save the table to.
+       */
+      void save(const std::string& path) const;
+
+      /**
+       * Open a lookup table saved using `save()`, which must hold vectors of
+       * this size.
+       *
+       * @param path The path of the file to open.
+       * @return The opened lookup table.
+       */
+      static basic_table open(const std::string& path);
+
+      /**
+       * Compute a number of statistics for this lookup table.
+       *
+       * @return The statistics computed for this lookup table.
+       */
+      table::statistics stats() const;
+  };
+
+  /**
+   * Construct a new fixed-size lookup table from a lookup table of the same
+   * size.
+   *
+   * @param table The lookup table holding the vectors.
+   */
+  template <unsigned int Bits>
+  basic_table<Bits>::basic_table(table&& t): table_(std::move(t)) {}
+
+  /**
+   * Construct a new classic lookup table.
+   *
+   * @param config The configuration parameters for the lookup table.
+   */
+  template <unsigned int Bits>
+  basic_table<Bits>::basic_table(const classic& c)
+    : table_(table::classic({.dimensions = Bits, .samples = c.samples, .partitions = c.partitions, .probes = c.probes, .seed = c.seed, .resource = c.resource})) {}
+
+  /**
+   * Construct a new covering lookup table.
+   *
+   * @param config The configuration parameters for the lookup table.
+   */
+  template <unsigned int Bits>
+  basic_table<Bits>::basic_table(const covering& c)
+    : table_(table::covering({.dimensions = Bits, .radius = c.radius, .seed = c.seed, .resource = c.resource})) {}
+
+  /**
+   * Construct a brute-force lookup table.
+   *
+   * @param config The configuration parameters for the lookup table.
+   */
+  template <unsigned int Bits>
+  basic_table<Bits>::basic_table(const brute& c)
+    : table_(table::brute({.dimensions = Bits, .resource = c.resource})) {}
+
+  /**
+   * Get the number of vectors in this lookup table.
+   *
+   * @return The number of vectors in this lookup table.
+   */
+  template <unsigned int Bits>
+  unsigned int basic_table<Bits>::size() const {
+    return this->table_.size();
+  }
+
+  /**
+   * Check if this lookup table has been frozen.
+   *
+   * @return `true` if this lookup table has been frozen, otherwise `false`.
+   */
+  template <unsigned int Bits>
+  bool basic_table<Bits>::frozen() const {
+    return this->table_.frozen();
+  }
+
+  /**
+   * Freeze this lookup table, rewriting its partitions into compact arrays
+   * that are faster to query. A frozen table can no longer be modified.
+   *
+   * @param compress Whether or not to compress the vector ids of the buckets.
+   */
+  template <unsigned int Bits>
+  void basic_table<Bits>::freeze(bool z) {
+    this->table_.freeze(z);
+  }
+
+  /**
+   * Insert a vector into this lookup table.
+   *
+   * @param vector The vector to insert into this lookup table.
+   * @return The id of the vector, which stays the same until the vector is erased.
+   */
+  template <unsigned int Bits>
+  unsigned int basic_table<Bits>::insert(const basic_vector<Bits>& v) {
+    return this->table_.add(v.data());
+  }
+
+  /**
+   * Insert a number of vectors into this lookup table using a number of worker
+   * threads.
+   *
+   * @param vectors The vectors to insert into this lookup table.
+   * @param n The number of vectors.
+   * @param threads The number of worker threads, or 0 to use one per hardware thread.
+   * @return The ids of the vectors, in the order they were given.
+   */
+  template <unsigned int Bits>
+  std::vector<unsigned int> basic_table<Bits>::insert_batch(const basic_vector<Bits>* vs, std::size_t n, unsigned int t) {
+    std::vector<const kernel::word*> cs(n);
+
+    for (std::size_t i = 0; i < n; i++) {
+      cs[i] = vs[i].data();
+    }
+
+    return this->table_.add_batch(cs.data(), n, t);
+  }
+
+  /**
+   * Erase a vector from this lookup table.
+   *
+   * @param vector The vector to erase from this lookup table.
+   * @return `true` if the vector was found and erased, otherwise `false`.
+   */
+  template <unsigned int Bits>
+  bool basic_table<Bits>::erase(const basic_vector<Bits>& v) {
+    return this->table_.discard(v.data());
+  }
+
+  /**
+   * Erase the vector with a given id from this lookup table.
+   *
+   * @param id The id of the vector to erase from this lookup table.
+   * @return `true` if the vector was found and erased, otherwise `false`.
+   */
+  template <unsigned int Bits>
+  bool basic_table<Bits>::erase(unsigned int id) {
+    return this->table_.erase(id);
+  }
+
+  /**
+   * Query this lookup table for the id of and distance to the nearest
+   * neighbour of a query vector.
+   *
+   * @param vector The query vector to look up the nearest neighbour of.
+   * @return The nearest neighbour if found, otherwise a result with an id and distance of `UINT_MAX`.
+   */
+  template <unsigned int Bits>
+  table::result basic_table<Bits>::query_nearest(const basic_vector<Bits>& v) const {
+    return this->table_.template search<fixed>(v.data());
+  }
+
+  /**
+   * Query this lookup table for the k nearest neighbours of a query vector.
+   *
+   * @param vector The query vector to look up the nearest neighbours of.
+   * @param k The number of nearest neighbours to look up.
+   * @return Up to k nearest neighbours found, ordered by increasing distance.
+   */
+  template <unsigned int Bits>
+  std::vector<table::result> basic_table<Bits>::query_k(const basic_vector<Bits>& v, unsigned int k) const {
+    return this->table_.template search_k<fixed>(v.data(), k);
+  }
+
+  /**
+   * Query this lookup table for the neighbours of a query vector within a
+   * given distance.
+   *
+   * @param vector The query vector to look up the neighbours of.
+   * @param radius The distance within which to look up neighbours.
+   * @return The neighbours found within the distance, ordered by increasing distance.
+   */
+  template <unsigned int Bits>
+  std::vector<table::result> basic_table<Bits>::query_radius(const basic_vector<Bits>& v, unsigned int r) const {
+    return this->table_.template search_radius<fixed>(v.data(), r);
+  }
+
+  /**
+   * Query this lookup table for any neighbour of a query vector within a given
+   * distance, stopping as soon as one is found.
+   *
+   * @param vector The query vector to look up a neighbour of.
+   * @param radius The distance within which to look up a neighbour.
+   * @return The first neighbour found within the distance, otherwise the nearest neighbour found.
+   */
+  template <unsigned int Bits>
+  table::result basic_table<Bits>::query_any(const basic_vector<Bits>& v, unsigned int r) const {
+    return this->table_.template search<fixed>(v.data(), r);
+  }
+
+  /**
+   * Query this lookup table for the nearest neighbours of a number of query
+   * vectors, splitting the queries across the workers of a pool.
+   *
+   * @param vectors The query vectors to look up the nearest neighbours of.
+   * @param n The number of query vectors.
+   * @param results The array to write the result of each query to.
+   * @param pool The pool of workers to run the queries on.
+   */
+  template <unsigned int Bits>
+  void basic_table<Bits>::query_batch(const basic_vector<Bits>* vs, std::size_t n, table::result* rs, pool& p) const {
+    std::vector<const kernel::word*> cs(n);
+
+    for (std::size_t i = 0; i < n; i++) {
+      cs[i] = vs[i].data();
+    }
+
+    this->table_.template search_batch<fixed>(cs.data(), n, rs, p);
+  }
+
+  /**
+   * Query this lookup table for the nearest neighbours of a number of query
+   * vectors using a number of worker threads.
+   *
+   * @param vectors The query vectors to look up the nearest neighbours of.
+   * @param n The number of query vectors.
+   * @param results The array to write the result of each query to.
+   * @param threads The number of worker threads, or 0 to use one per hardware thread.
+   */
+  template <unsigned int Bits>
+  void basic_table<Bits>::query_batch(const basic_vector<Bits>* vs, std::size_t n, table::result* rs, unsigned int t) const {
+    pool p(t);
+
+    this->query_batch(vs, n, rs, p);
+  }
+
+  /**
+   * Save this lookup table to a file that can later be opened using
+   * `basic_table::open()` or `table::open()`.
+   *
+   * @param path The path of the file to save the table to.
+   */
+  template <unsigned int Bits>
+  void basic_table<Bits>::save(const std::string& path) const {
+    this->table_.save(path);
+  }
+
+  /**
+   * Open a lookup table saved using `save()`, which must hold vectors of this
+   * size.
+   *
+   * @param path The path of the file to open.
+   * @return The opened lookup table.
+   */
+  template <unsigned int Bits>
+  basic_table<Bits> basic_table<Bits>::open(const std::string& path) {
+    table t = table::open(path);
+
+    if (t.dimensions_ != Bits) {
+      throw std::invalid_argument("Invalid vector size");
+    }
+
+    return basic_table(std::move(t));
+  }
+
+  /**
+   * Compute a number of statistics for this lookup table.
+   *
+   * @return The statistics computed for this lookup table.
+   */
+  template <unsigned int Bits>
+  table::statistics basic_table<Bits>::stats() const {
+    return this->table_.stats();
+  }
+}
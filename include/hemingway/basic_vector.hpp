@@ -0,0 +1,381 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <array>
+#include <hemingway/kernel.hpp>
+#include <hemingway/generator.hpp>
+#include <hemingway/vector_view.hpp>
+
+namespace lsh {
+  /**
+   * A vector whose number of components is fixed at compile time. The
+   * components are stored inline, so the vector needs no heap allocation and
+   * operations on two vectors need no size checks. Use `lsh::vector` for
+   * sizes that are not a multiple of 64.
+   *
+   * @tparam Bits The number of components in the vector.
+   */
+  template <unsigned int Bits>
+  class basic_vector {
+    static_assert(Bits > 0 && Bits % 64 == 0, "The number of components must be a positive multiple of 64");
+
+    public:
+      /**
+       * The number of component chunks in vectors of this size.
+       */
+      static const unsigned int chunks = Bits / 64;
+
+    private:
+      /**
+       * The chunked components of this vector.
+       */
+      std::array<kernel::word, chunks> components_;
+
+    public:
+      /**
+       * Create a new vector with all components cleared.
+       */
+      basic_vector();
+
+      /**
+       * Create a new vector from components packed into words, using the
+       * layout described by `lsh::vector_view`.
+       *
+       * @param components The words holding the components.
+       */
+      explicit basic_vector(const kernel::word* components);
+
+      /**
+       * Create a new vector.
+       *
+       * @param components The components of the vector.
+       */
+      basic_vector(const std::vector<bool>& components);
+
+      /**
+       * Create a new vector holding a copy of the components of a view.
+       *
+       * @param vector The view to copy.
+       */
+      explicit basic_vector(const vector_view& vector);
+
+      /**
+       * Get the number of components in vectors of this size.
+       *
+       * @return The number of components in vectors of this size.
+       */
+      static constexpr unsigned int size() {
+        return Bits;
+      }
+
+      /**
+       * Get the words holding the components of this vector.
+       *
+       * @return The words holding the components of this vector.
+       */
+      const kernel::word* data() const;
+
+      /**
+       * Get a view of the components of this vector. The view is invalidated
+       * when the vector is destroyed.
+       *
+       * @return A view of the components of this vector.
+       */
+      operator vector_view() const;
+
+      /**
+       * Get the component at the specified index of this vector.
+       *
+       * @param index The index of the component to get.
+       * @return The component at the index.
+       */
+      bool get(unsigned int index) const;
+
+      /**
+       * Get a string representation of this vector.
+       *
+       * @return The string representation of the vector.
+       */
+      std::string to_string() const;
+
+      /**
+       * Check if this vector is equal to another vector.
+       *
+       * @param vector The other vector.
+       * @return `true` if this vector equals the other vector, otherwise `false`.
+       */
+      bool operator==(const basic_vector& vector) const;
+
+      /**
+       * Check if this vector is different from another vector.
+       *
+       * @param vector The other vector.
+       * @return `true` if this vector differs from the other vector, otherwise `false`.
+       */
+      bool operator!=(const basic_vector& vector) const;
+
+      /**
+       * Compute the dot product of this and another vector.
+       *
+       * @param vector The other vector.
+       * @return The dot product of this and another vector.
+       */
+      unsigned int operator*(const basic_vector& vector) const;
+
+      /**
+       * Compute the bitwise AND of this and another vector.
+       *
+       * @param vector The other vector.
+       * @return The bitwise AND of this and another vector.
+       */
+      basic_vector operator&(const basic_vector& vector) const;
+
+      /**
+       * Compute the hash of this vector. The hash equals that of an
+       * `lsh::vector` with the same components.
+       *
+       * @return The hash of this vector.
+       */
+      unsigned int hash() const;
+
+      /**
+       * Compute the distance between two vectors.
+       *
+       * @param u The first vector.
+       * @param v The second vector.
+       * @return The distance between the two vectors.
+       */
+      static unsigned int distance(const basic_vector& u, const basic_vector& v);
+
+      /**
+       * Construct a random vector.
+       *
+       * @return The randomly generated vector.
+       */
+      static basic_vector random();
+
+      /**
+       * Construct a random vector, drawing its components from a generator.
+       *
+       * @param generator The generator to draw the components from.
+       * @return The randomly generated vector.
+       */
+      static basic_vector random(generator& generator);
+  };
+
+  /**
+   * Create a new vector with all components cleared.
+   */
+  template <unsigned int Bits>
+  basic_vector<Bits>::basic_vector() {
+    this->components_.fill(0);
+  }
+
+  /**
+   * Create a new vector from components packed into words, using the layout
+   * described by `lsh::vector_view`.
+   *
+   * @param components The words holding the components.
+   */
+  template <unsigned int Bits>
+  basic_vector<Bits>::basic_vector(const kernel::word* cs) {
+    for (unsigned int i = 0; i < chunks; i++) {
+      this->components_[i] = cs[i];
+    }
+  }
+
+  /**
+   * Create a new vector.
+   *
+   * @param components The components of the vector.
+   */
+  template <unsigned int Bits>
+  basic_vector<Bits>::basic_vector(const std::vector<bool>& cs) {
+    if (cs.size() != Bits) {
+      throw std::invalid_argument("Invalid vector size");
+    }
+
+    for (unsigned int i = 0; i < chunks; i++) {
+      kernel::word e = 0;
+
+      for (unsigned int j = 0; j < 64; j++) {
+        e |= kernel::word(cs[i * 64 + j]) << (63 - j);
+      }
+
+      this->components_[i] = e;
+    }
+  }
+
+  /**
+   * Create a new vector holding a copy of the components of a view.
+   *
+   * @param vector The view to copy.
+   */
+  template <unsigned int Bits>
+  basic_vector<Bits>::basic_vector(const vector_view& v) {
+    if (v.size() != Bits) {
+      throw std::invalid_argument("Invalid vector size");
+    }
+
+    for (unsigned int i = 0; i < chunks; i++) {
+      this->components_[i] = v.data()[i];
+    }
+  }
+
+  /**
+   * Get the words holding the components of this vector.
+   *
+   * @return The words holding the components of this vector.
+   */
+  template <unsigned int Bits>
+  const kernel::word* basic_vector<Bits>::data() const {
+    return this->components_.data();
+  }
+
+  /**
+   * Get a view of the components of this vector. The view is invalidated when
+   * the vector is destroyed.
+   *
+   * @return A view of the components of this vector.
+   */
+  template <unsigned int Bits>
+  basic_vector<Bits>::operator vector_view() const {
+    return vector_view(this->components_.data(), Bits);
+  }
+
+  /**
+   * Get the component at the specified index of this vector.
+   *
+   * @param index The index of the component to get.
+   * @return The component at the index.
+   */
+  template <unsigned int Bits>
+  bool basic_vector<Bits>::get(unsigned int i) const {
+    if (i >= Bits) {
+      throw std::out_of_range("Invalid index");
+    }
+
+    return (this->components_[i / 64] >> (63 - i % 64)) & 1;
+  }
+
+  /**
+   * Get a string representation of this vector.
+   *
+   * @return The string representation of the vector.
+   */
+  template <unsigned int Bits>
+  std::string basic_vector<Bits>::to_string() const {
+    std::string value = "Vector[";
+
+    for (unsigned int i = 0; i < Bits; i++) {
+      value += std::to_string(this->get(i));
+    }
+
+    return value + "]";
+  }
+
+  /**
+   * Check if this vector is equal to another vector.
+   *
+   * @param vector The other vector.
+   * @return `true` if this vector equals the other vector, otherwise `false`.
+   */
+  template <unsigned int Bits>
+  bool basic_vector<Bits>::operator==(const basic_vector& v) const {
+    return this->components_ == v.components_;
+  }
+
+  /**
+   * Check if this vector is different from another vector.
+   *
+   * @param vector The other vector.
+   * @return `true` if this vector differs from the other vector, otherwise `false`.
+   */
+  template <unsigned int Bits>
+  bool basic_vector<Bits>::operator!=(const basic_vector& v) const {
+    return !(*this == v);
+  }
+
+  /**
+   * Compute the dot product of this and another vector.
+   *
+   * @param vector The other vector.
+   * @return The dot product of this and another vector.
+   */
+  template <unsigned int Bits>
+  unsigned int basic_vector<Bits>::operator*(const basic_vector& v) const {
+    return kernel::dot<chunks>(this->components_.data(), v.components_.data());
+  }
+
+  /**
+   * Compute the bitwise AND of this and another vector.
+   *
+   * @param vector The other vector.
+   * @return The bitwise AND of this and another vector.
+   */
+  template <unsigned int Bits>
+  basic_vector<Bits> basic_vector<Bits>::operator&(const basic_vector& v) const {
+    basic_vector r;
+
+    for (unsigned int i = 0; i < chunks; i++) {
+      r.components_[i] = this->components_[i] & v.components_[i];
+    }
+
+    return r;
+  }
+
+  /**
+   * Compute the hash of this vector. The hash equals that of an `lsh::vector`
+   * with the same components.
+   *
+   * @return The hash of this vector.
+   */
+  template <unsigned int Bits>
+  unsigned int basic_vector<Bits>::hash() const {
+    return vector_view(*this).hash();
+  }
+
+  /**
+   * Compute the distance between two vectors.
+   *
+   * @param u The first vector.
+   * @param v The second vector.
+   * @return The distance between the two vectors.
+   */
+  template <unsigned int Bits>
+  unsigned int basic_vector<Bits>::distance(const basic_vector& u, const basic_vector& v) {
+    return kernel::distance<chunks>(u.components_.data(), v.components_.data());
+  }
+
+  /**
+   * Construct a random vector.
+   *
+   * @return The randomly generated vector.
+   */
+  template <unsigned int Bits>
+  basic_vector<Bits> basic_vector<Bits>::random() {
+    static thread_local generator g;
+
+    return basic_vector::random(g);
+  }
+
+  /**
+   * Construct a random vector, drawing its components from a generator.
+   *
+   * @param generator The generator to draw the components from.
+   * @return The randomly generated vector.
+   */
+  template <unsigned int Bits>
+  basic_vector<Bits> basic_vector<Bits>::random(generator& g) {
+    basic_vector r;
+
+    for (unsigned int i = 0; i < chunks; i++) {
+      r.components_[i] = g();
+    }
+
+    return r;
+  }
+}
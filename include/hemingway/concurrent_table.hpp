@@ -0,0 +1,200 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <hemingway/vector.hpp>
+#include <hemingway/table.hpp>
+
+namespace lsh {
+  /**
+   * A lookup table that can be queried from any number of threads while other
+   * threads insert and erase vectors. Readers lock one of a number of lock
+   * stripes, picked per thread, so that readers on different threads do not
+   * contend with each other. Writers lock every stripe, which makes writes
+   * more expensive in exchange for queries that scale across cores. Writers
+   * take precedence over readers that arrive after them, such that a steady
+   * stream of queries cannot starve writes.
+   */
+  class concurrent_table {
+    private:
+      /**
+       * A lock stripe, padded such that no two stripes share a cache line.
+       */
+      struct stripe {
+        /**
+         * The mutex of the stripe.
+         */
+        std::mutex mutex;
+
+        /**
+         * Padding separating the mutex from that of the next stripe.
+         */
+        char padding[64];
+      };
+
+      /**
+       * Holds every lock stripe of a table for the duration of a write.
+       */
+      class exclusive {
+        private:
+          /**
+           * The table whose stripes are held.
+           */
+          const concurrent_table& table_;
+
+        public:
+          /**
+           * Lock every stripe of a table.
+           *
+           * @param table The table to lock.
+           */
+          exclusive(const concurrent_table& table);
+
+          /**
+           * Unlock every stripe of the table.
+           */
+          ~exclusive();
+      };
+
+      /**
+       * The lookup table holding the vectors.
+       */
+      table table_;
+
+      /**
+       * The number of lock stripes.
+       */
+      unsigned int stripes_;
+
+      /**
+       * The lock stripes guarding the table.
+       */
+      std::unique_ptr<stripe[]> locks_;
+
+      /**
+       * The number of writers waiting for or holding the lock stripes.
+       */
+      mutable std::atomic<unsigned int> writers_;
+
+      /**
+       * The lock held by a writer while it takes and holds the lock stripes,
+       * which readers pass through while writers are waiting.
+       */
+      mutable std::mutex gate_;
+
+      /**
+       * Get the lock stripe of the calling thread, first waiting for any
+       * writers that are waiting for or holding the lock stripes.
+       *
+       * @return The mutex of the lock stripe of the calling thread.
+       */
+      std::mutex& shared() const;
+
+    public:
+      /**
+       * Construct a new concurrent lookup table.
+       *
+       * @param table The lookup table to make concurrent.
+       * @param stripes The number of lock stripes, or 0 to use one per hardware thread.
+       */
+      concurrent_table(const table& table, unsigned int stripes = 0);
+
+      /**
+       * Get the number of vectors in this lookup table.
+       *
+       * @return The number of vectors in this lookup table.
+       */
+      unsigned int size() const;
+
+      /**
+       * Insert a vector into this lookup table.
+       *
+       * @param vector The vector to insert into this lookup table.
+       * @return The id of the vector, which stays the same until the vector is erased.
+       */
+      unsigned int insert(const vector_view& vector);
+
+      /**
+       * Insert a number of vectors into this lookup table at once, holding off
+       * readers only once for the whole batch.
+       *
+       * @param vectors The vectors to insert into this lookup table.
+       * @param n The number of vectors.
+       * @param threads The number of worker threads, or 0 to use one per hardware thread.
+       * @return The ids of the vectors, in the order they were given.
+       */
+      std::vector<unsigned int> insert_batch(const vector* vectors, std::size_t n, unsigned int threads = 0);
+
+      /**
+       * Erase a vector from this lookup table.
+       *
+       * @param vector The vector to erase from this lookup table.
+       * @return `true` if the vector was found and erased, otherwise `false`.
+       */
+      bool erase(const vector_view& vector);
+
+      /**
+       * Erase the vector with a given id from this lookup table.
+       *
+       * @param id The id of the vector to erase from this lookup table.
+       * @return `true` if the vector was found and erased, otherwise `false`.
+       */
+      bool erase(unsigned int id);
+
+      /**
+       * Query this lookup table for the nearest neighbour of a query vector.
+       *
+       * @param vector The query vector to look up the nearest neighbour of.
+       * @return The nearest neighbouring vector if found, otherwise a vector of size 0.
+       */
+      vector query(const vector_view& vector) const;
+
+      /**
+       * Query this lookup table for the id of and distance to the nearest
+       * neighbour of a query vector.
+       *
+       * @param vector The query vector to look up the nearest neighbour of.
+       * @return The nearest neighbour if found, otherwise a result with an id and distance of `UINT_MAX`.
+       */
+      table::result query_nearest(const vector_view& vector) const;
+
+      /**
+       * Query this lookup table for the k nearest neighbours of a query vector.
+       *
+       * @param vector The query vector to look up the nearest neighbours of.
+       * @param k The number of nearest neighbours to look up.
+       * @return Up to k nearest neighbours found, ordered by increasing distance.
+       */
+      std::vector<table::result> query_k(const vector_view& vector, unsigned int k) const;
+
+      /**
+       * Query this lookup table for the neighbours of a query vector within a
+       * given distance.
+       *
+       * @param vector The query vector to look up the neighbours of.
+       * @param radius The distance within which to look up neighbours.
+       * @return The neighbours found within the distance, ordered by increasing distance.
+       */
+      std::vector<table::result> query_radius(const vector_view& vector, unsigned int radius) const;
+
+      /**
+       * Query this lookup table for any neighbour of a query vector within a
+       * given distance, stopping as soon as one is found.
+       *
+       * @param vector The query vector to look up a neighbour of.
+       * @param radius The distance within which to look up a neighbour.
+       * @return The first neighbour found within the distance, otherwise the nearest neighbour found.
+       */
+      table::result query_any(const vector_view& vector, unsigned int radius) const;
+
+      /**
+       * Compute a number of statistics for this lookup table.
+       *
+       * @return The statistics computed for this lookup table.
+       */
+      table::statistics stats() const;
+  };
+}
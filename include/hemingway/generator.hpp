@@ -0,0 +1,107 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#pragma once
+
+#include <cstdint>
+
+namespace lsh {
+  /**
+   * A fast pseudorandom generator of 64-bit words, implementing xoshiro256**.
+   * Generators constructed from the same seed produce the same words on every
+   * platform, which makes tables built from them reproducible.
+   */
+  class generator {
+    private:
+      /**
+       * The state of the generator.
+       */
+      std::uint64_t state_[4];
+
+    public:
+      typedef std::uint64_t result_type;
+
+      /**
+       * Construct a new generator seeded from a source of true randomness.
+       */
+      generator();
+
+      /**
+       * Construct a new generator from a seed.
+       *
+       * @param seed The seed, which is expanded into the state of the generator using splitmix64.
+       */
+      explicit generator(std::uint64_t seed);
+
+      /**
+       * Draw a seed from a source of true randomness.
+       *
+       * @return The seed.
+       */
+      static std::uint64_t entropy();
+
+      /**
+       * Get the smallest word that the generator produces.
+       *
+       * @return The smallest word that the generator produces.
+       */
+      static constexpr result_type min() {
+        return 0;
+      }
+
+      /**
+       * Get the largest word that the generator produces.
+       *
+       * @return The largest word that the generator produces.
+       */
+      static constexpr result_type max() {
+        return UINT64_MAX;
+      }
+
+      /**
+       * Generate the next word.
+       *
+       * @return A uniformly random 64-bit word.
+       */
+      result_type operator()();
+
+      /**
+       * Generate a number below a bound.
+       *
+       * @param n The exclusive upper bound.
+       * @return A random number between 0 and n - 1.
+       */
+      unsigned int below(unsigned int n);
+  };
+
+  /**
+   * Generate the next word.
+   *
+   * @return A uniformly random 64-bit word.
+   */
+  inline generator::result_type generator::operator()() {
+    std::uint64_t* s = this->state_;
+
+    std::uint64_t x = s[1] * 5;
+    std::uint64_t r = (x << 7 | x >> 57) * 9;
+    std::uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = s[3] << 45 | s[3] >> 19;
+
+    return r;
+  }
+
+  /**
+   * Generate a number below a bound, by scaling the upper half of a word.
+   * The bias this introduces is below 2^-32 for any bound.
+   *
+   * @param n The exclusive upper bound.
+   * @return A random number between 0 and n - 1.
+   */
+  inline unsigned int generator::below(unsigned int n) {
+    return ((*this)() >> 32) * n >> 32;
+  }
+}
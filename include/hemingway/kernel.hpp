@@ -0,0 +1,288 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#pragma once
+
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace lsh {
+  namespace kernel {
+    /**
+     * A machine word of packed vector components.
+     */
+    typedef std::uint64_t word;
+
+    /**
+     * A mask of bits to extract from a single word of a vector.
+     */
+    struct mask {
+      /**
+       * The index of the word to extract bits from.
+       */
+      unsigned int index;
+
+      /**
+       * The bits to extract from the word.
+       */
+      word bits;
+    };
+
+    /**
+     * The instruction sets that kernels are provided for.
+     */
+    enum isa {
+      /**
+       * Portable code that runs on any host.
+       */
+      generic,
+
+      /**
+       * The scalar POPCNT instruction.
+       */
+      popcnt,
+
+      /**
+       * AVX2 using a Harley-Seal carry-save adder and a nibble lookup table.
+       */
+      avx2,
+
+      /**
+       * AVX-512 using the VPOPCNTQ instruction, along with the BMI2 PEXT
+       * instruction for extracting bits.
+       */
+      avx512
+    };
+
+    /**
+     * Check if the host supports the kernels of an instruction set.
+     *
+     * @param isa The instruction set to check.
+     * @return `true` if the kernels can run on the host, otherwise `false`.
+     */
+    bool supported(isa isa);
+
+    /**
+     * Get the fastest instruction set supported by the host.
+     *
+     * @return The fastest instruction set supported by the host.
+     */
+    isa best();
+
+    /**
+     * Get the instruction set whose kernels are currently in use.
+     *
+     * @return The instruction set whose kernels are currently in use.
+     */
+    isa active();
+
+    /**
+     * Use the kernels of an instruction set for all subsequent calls.
+     *
+     * @param isa The instruction set to use.
+     */
+    void select(isa isa);
+
+    /**
+     * Get the name of an instruction set.
+     *
+     * @param isa The instruction set.
+     * @return The name of the instruction set.
+     */
+    std::string name(isa isa);
+
+    /**
+     * Compute the Hamming distance between two sequences of words.
+     *
+     * @param u The words of the first vector.
+     * @param v The words of the second vector.
+     * @param n The number of words in each vector.
+     * @return The number of bits that differ between the two vectors.
+     */
+    unsigned int distance(const word* u, const word* v, unsigned int n);
+
+    /**
+     * Compute the Hamming distance between two sequences of words, giving up
+     * once it is known to reach a bound. The running distance is checked
+     * against the bound after every cache line of words, which rejects most
+     * far away vectors after reading a fraction of them. Tables keep the
+     * weight of each vector alongside it as a cheaper lower bound to check
+     * first, in place of a separate sketch word.
+     *
+     * @param u The words of the first vector.
+     * @param v The words of the second vector.
+     * @param n The number of words in each vector.
+     * @param bound The distance at which to give up.
+     * @return The number of bits that differ between the two vectors if below the bound, otherwise a number no smaller than the bound.
+     */
+    unsigned int distance(const word* u, const word* v, unsigned int n, unsigned int bound);
+
+    /**
+     * Compute the Hamming distances between a vector and a number of candidate
+     * vectors stored back to back.
+     *
+     * @param u The words of the query vector.
+     * @param vs The words of the candidate vectors.
+     * @param n The number of words in each vector.
+     * @param m The number of candidate vectors.
+     * @param ds The array to write the `m` distances to.
+     */
+    void distance(const word* u, const word* vs, unsigned int n, unsigned int m, unsigned int* ds);
+
+    /**
+     * Compute the dot product of two sequences of words.
+     *
+     * @param u The words of the first vector.
+     * @param v The words of the second vector.
+     * @param n The number of words in each vector.
+     * @return The number of bits that are set in both vectors.
+     */
+    unsigned int dot(const word* u, const word* v, unsigned int n);
+
+    /**
+     * Count the bits set in a sequence of words.
+     *
+     * @param v The words of the vector.
+     * @param n The number of words in the vector.
+     * @return The number of bits that are set in the vector.
+     */
+    unsigned int weight(const word* v, unsigned int n);
+
+    /**
+     * Gather the bits selected by a sequence of masks into a compact key. The
+     * extracted bits of each mask are appended to the key in order, such that
+     * the key is exact as long as the masks select at most 64 bits in total.
+     * Beyond that, earlier bits are rotated back into the key and combined
+     * with later bits.
+     *
+     * @param v The words of the vector to extract bits from.
+     * @param ms The masks selecting the bits to extract.
+     * @param n The number of masks.
+     * @return The extracted bits.
+     */
+    word extract(const word* v, const mask* ms, unsigned int n);
+
+    /**
+     * Encode a sorted sequence of ids as the differences between consecutive
+     * ids, using Stream VByte: The byte length of each difference is stored
+     * in 2 bits of a control byte, four to a byte, and the control bytes are
+     * followed by the differences themselves in as few bytes as they fit.
+     *
+     * @see https://arxiv.org/abs/1709.08990
+     *
+     * @param ids The ids to encode, in increasing order.
+     * @param n The number of ids.
+     * @param out The array to write the at most `(n + 3) / 4 + 4 * n` encoded bytes to.
+     * @return The number of bytes written.
+     */
+    std::size_t encode(const unsigned int* ids, unsigned int n, std::uint8_t* out);
+
+    /**
+     * Decode a sequence of ids encoded using `kernel::encode()`. The decoder
+     * may read up to 16 bytes past the end of the encoded ids.
+     *
+     * @param in The encoded bytes.
+     * @param n The number of ids.
+     * @param ids The array to write the `n` decoded ids to.
+     * @return The number of bytes read.
+     */
+    std::size_t decode(const std::uint8_t* in, unsigned int n, unsigned int* ids);
+
+    /**
+     * Count the bits set in either the XOR (`X = true`) or the AND
+     * (`X = false`) of two sequences of a fixed number of words, fully
+     * unrolled. On x86 hosts this is compiled for POPCNT whatever the flags of
+     * the translation unit, so callers must check `unroll` first. It is only
+     * inlined into callers that are themselves compiled for POPCNT, and is
+     * called out of line otherwise.
+     *
+     * @tparam N The number of words in each vector.
+     * @tparam X Whether to count the bits of the XOR rather than the AND.
+     * @param u The words of the first vector.
+     * @param v The words of the second vector.
+     * @return The number of bits set.
+     */
+    template <unsigned int N, bool X>
+#if defined(__x86_64__) || defined(__i386__)
+    __attribute__((target("popcnt")))
+#endif
+    inline unsigned int count_fixed(const word* u, const word* v) {
+      unsigned int d = 0;
+
+      for (unsigned int i = 0; i < N; i++) {
+        d += __builtin_popcountll(X ? u[i] ^ v[i] : u[i] & v[i]);
+      }
+
+      return d;
+    }
+
+    /**
+     * The largest number of words that fixed size kernels count using POPCNT
+     * themselves. Longer vectors are faster to count using the kernels
+     * selected at runtime, which use vector instructions.
+     */
+    const unsigned int unrolled = 3;
+
+    /**
+     * Whether the host supports the POPCNT instruction used by `count_fixed()`,
+     * detected once at startup. It reads `false` until then, such that fixed
+     * size kernels used during static initialization fall back to the kernels
+     * selected at runtime.
+     */
+    extern const bool unroll;
+
+    /**
+     * Compute the Hamming distance between two sequences of a fixed number of
+     * words. Up to `unrolled` words, the bits are counted by `count_fixed()`
+     * if the translation unit is compiled with POPCNT or the host supports it.
+     * Longer vectors and hosts without POPCNT use the kernel selected at
+     * runtime.
+     *
+     * @tparam N The number of words in each vector.
+     * @param u The words of the first vector.
+     * @param v The words of the second vector.
+     * @return The number of bits that differ between the two vectors.
+     */
+    template <unsigned int N>
+    inline unsigned int distance(const word* u, const word* v) {
+      if (N > unrolled) {
+        return distance(u, v, N);
+      }
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(__POPCNT__)
+      if (!unroll) {
+        return distance(u, v, N);
+      }
+#endif
+
+      return count_fixed<N, true>(u, v);
+    }
+
+    /**
+     * Compute the dot product of two sequences of a fixed number of words.
+     * Up to `unrolled` words, the bits are counted by `count_fixed()` if the
+     * translation unit is compiled with POPCNT or the host supports it.
+     * Longer vectors and hosts without POPCNT use the kernel selected at
+     * runtime.
+     *
+     * @tparam N The number of words in each vector.
+     * @param u The words of the first vector.
+     * @param v The words of the second vector.
+     * @return The number of bits that are set in both vectors.
+     */
+    template <unsigned int N>
+    inline unsigned int dot(const word* u, const word* v) {
+      if (N > unrolled) {
+        return dot(u, v, N);
+      }
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(__POPCNT__)
+      if (!unroll) {
+        return dot(u, v, N);
+      }
+#endif
+
+      return count_fixed<N, false>(u, v);
+    }
+  }
+}
@@ -0,0 +1,269 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace lsh {
+  /**
+   * A source of memory for the internals of lookup tables, along the lines of
+   * `std::pmr::memory_resource`. Implementations must be safe to use from
+   * several threads at once, as tables are filled in parallel.
+   */
+  class memory_resource {
+    public:
+      virtual ~memory_resource();
+
+      /**
+       * Allocate a block of memory.
+       *
+       * @param n The number of bytes to allocate.
+       * @param alignment The alignment of the block, which is a power of two.
+       * @return The start of the block.
+       */
+      virtual void* allocate(std::size_t n, std::size_t alignment) = 0;
+
+      /**
+       * Deallocate a block of memory allocated from this resource.
+       *
+       * @param block The start of the block.
+       * @param n The number of bytes that were allocated.
+       * @param alignment The alignment the block was allocated with.
+       */
+      virtual void deallocate(void* block, std::size_t n, std::size_t alignment) = 0;
+  };
+
+  /**
+   * Get the resource that allocates memory from the heap, which tables use
+   * unless told otherwise.
+   *
+   * @return The heap resource.
+   */
+  memory_resource* default_resource();
+
+  /**
+   * A monotonic memory resource that hands out memory from large chunks
+   * allocated from an upstream resource. Deallocating is a no-op; the memory
+   * is only returned once the arena is released or destroyed. This suits
+   * tables that are built once and then only queried, replacing the many
+   * small allocations of their buckets with a few large ones.
+   */
+  class arena: public memory_resource {
+    private:
+      /**
+       * The resource that chunks are allocated from.
+       */
+      memory_resource* upstream_;
+
+      /**
+       * The number of bytes in the first chunk.
+       */
+      std::size_t initial_;
+
+      /**
+       * The number of bytes in the next chunk.
+       */
+      std::size_t next_;
+
+      /**
+       * The next free byte of the current chunk.
+       */
+      char* current_;
+
+      /**
+       * The number of free bytes left in the current chunk.
+       */
+      std::size_t left_;
+
+      /**
+       * The start and number of bytes of every chunk.
+       */
+      std::vector<std::pair<void*, std::size_t>> chunks_;
+
+      /**
+       * The lock guarding the chunks.
+       */
+      mutable std::mutex mutex_;
+
+    public:
+      /**
+       * Construct a new arena.
+       *
+       * @param initial The number of bytes in the first chunk, which doubles for every chunk after it.
+       * @param upstream The resource to allocate chunks from, or `nullptr` to use the heap.
+       */
+      explicit arena(std::size_t initial = 1 << 20, memory_resource* upstream = nullptr);
+
+      arena(const arena&) = delete;
+
+      arena& operator=(const arena&) = delete;
+
+      /**
+       * Destroy this arena, releasing all of its memory.
+       */
+      ~arena();
+
+      /**
+       * Allocate a block of memory from the current chunk, starting a new
+       * chunk if it has run out.
+       *
+       * @param n The number of bytes to allocate.
+       * @param alignment The alignment of the block, which is a power of two.
+       * @return The start of the block.
+       */
+      void* allocate(std::size_t n, std::size_t alignment);
+
+      /**
+       * Do nothing, as memory is only returned once the arena is released.
+       *
+       * @param block The start of the block.
+       * @param n The number of bytes that were allocated.
+       * @param alignment The alignment the block was allocated with.
+       */
+      void deallocate(void* block, std::size_t n, std::size_t alignment);
+
+      /**
+       * Return all chunks to the upstream resource. Every block allocated
+       * from this arena becomes invalid.
+       */
+      void release();
+
+      /**
+       * Get the number of bytes allocated from the upstream resource.
+       *
+       * @return The number of bytes in the chunks of this arena.
+       */
+      std::size_t size() const;
+  };
+
+  /**
+   * A memory resource that backs large blocks with huge pages, which cuts the
+   * number of TLB misses when queries access a large table at random. Blocks
+   * of at least one huge page are mapped on their own and aligned to huge
+   * pages, after which the kernel is asked to back them with transparent huge
+   * pages. Smaller blocks are allocated from an upstream resource. On hosts
+   * without transparent huge pages, large blocks use regular pages.
+   */
+  class huge_pages: public memory_resource {
+    private:
+      /**
+       * The resource that small blocks are allocated from.
+       */
+      memory_resource* upstream_;
+
+    public:
+      /**
+       * The number of bytes in a huge page.
+       */
+      static const std::size_t page = 2 << 20;
+
+      /**
+       * Construct a new huge page resource.
+       *
+       * @param upstream The resource to allocate small blocks from, or `nullptr` to use the heap.
+       */
+      explicit huge_pages(memory_resource* upstream = nullptr);
+
+      /**
+       * Allocate a block of memory.
+       *
+       * @param n The number of bytes to allocate.
+       * @param alignment The alignment of the block, which is a power of two.
+       * @return The start of the block.
+       */
+      void* allocate(std::size_t n, std::size_t alignment);
+
+      /**
+       * Deallocate a block of memory allocated from this resource.
+       *
+       * @param block The start of the block.
+       * @param n The number of bytes that were allocated.
+       * @param alignment The alignment the block was allocated with.
+       */
+      void deallocate(void* block, std::size_t n, std::size_t alignment);
+  };
+
+  /**
+   * An allocator that allocates from a memory resource, along the lines of
+   * `std::pmr::polymorphic_allocator`. Containers copied from one another use
+   * the heap rather than the resource of the original, such that the copies
+   * do not depend on the lifetime of the resource.
+   *
+   * @tparam T The type of objects to allocate.
+   */
+  template <typename T>
+  class allocator {
+    private:
+      /**
+       * The resource to allocate from.
+       */
+      memory_resource* resource_;
+
+    public:
+      typedef T value_type;
+
+      /**
+       * Construct a new allocator.
+       *
+       * @param resource The resource to allocate from, or `nullptr` to use the heap.
+       */
+      allocator(memory_resource* r = nullptr): resource_(r == nullptr ? default_resource() : r) {}
+
+      /**
+       * Construct a new allocator using the resource of another allocator.
+       *
+       * @param allocator The allocator whose resource to use.
+       */
+      template <typename U>
+      allocator(const allocator<U>& a): resource_(a.resource()) {}
+
+      /**
+       * Allocate memory for a number of objects.
+       *
+       * @param n The number of objects.
+       * @return The memory for the objects.
+       */
+      T* allocate(std::size_t n) {
+        return static_cast<T*>(this->resource_->allocate(n * sizeof(T), alignof(T)));
+      }
+
+      /**
+       * Deallocate memory for a number of objects.
+       *
+       * @param objects The memory for the objects.
+       * @param n The number of objects.
+       */
+      void deallocate(T* p, std::size_t n) {
+        this->resource_->deallocate(p, n * sizeof(T), alignof(T));
+      }
+
+      /**
+       * Get the allocator used by copies of containers using this allocator.
+       *
+       * @return An allocator that allocates from the heap.
+       */
+      allocator select_on_container_copy_construction() const {
+        return allocator();
+      }
+
+      /**
+       * Get the resource that this allocator allocates from.
+       *
+       * @return The resource of this allocator.
+       */
+      memory_resource* resource() const {
+        return this->resource_;
+      }
+  };
+
+  template <typename T, typename U>
+  inline bool operator==(const allocator<T>& a, const allocator<U>& b) {
+    return a.resource() == b.resource();
+  }
+
+  template <typename T, typename U>
+  inline bool operator!=(const allocator<T>& a, const allocator<U>& b) {
+    return a.resource() != b.resource();
+  }
+}
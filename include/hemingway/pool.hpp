@@ -0,0 +1,157 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#pragma once
+
+#include <list>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+namespace lsh {
+  class pool {
+    private:
+      /**
+       * A batch of tasks started by a call to `run()`.
+       */
+      struct batch {
+        /**
+         * The function running the tasks of the batch.
+         */
+        const std::function<void(unsigned int, unsigned int)>* task;
+
+        /**
+         * The number of tasks in the batch.
+         */
+        unsigned int tasks;
+
+        /**
+         * The worker running every task of the batch, or the number of workers
+         * if the tasks are spread over all workers.
+         */
+        unsigned int worker;
+
+        /**
+         * The number of workers that have yet to finish their share of the
+         * batch.
+         */
+        unsigned int pending;
+
+        /**
+         * The number of the batch, counting from 1 in the order batches were
+         * started.
+         */
+        unsigned long number;
+
+        /**
+         * The first exception thrown by a task of the batch.
+         */
+        std::exception_ptr error;
+      };
+
+      /**
+       * The worker threads of this pool.
+       */
+      std::vector<std::thread> threads_;
+
+      /**
+       * The mutex guarding the state of this pool.
+       */
+      std::mutex mutex_;
+
+      /**
+       * Signalled, one per worker, when a new batch of tasks is available to
+       * the worker or the pool is stopping.
+       */
+      std::unique_ptr<std::condition_variable[]> start_;
+
+      /**
+       * Signalled when a worker has finished its share of a batch of tasks.
+       */
+      std::condition_variable finish_;
+
+      /**
+       * The batches that have been started but not yet finished, in the order
+       * they were started.
+       */
+      std::list<batch> batches_;
+
+      /**
+       * The number of batches started so far.
+       */
+      unsigned long started_;
+
+      /**
+       * Whether or not the pool is stopping.
+       */
+      bool stopping_;
+
+      /**
+       * Run the tasks assigned to a worker until the pool stops.
+       *
+       * @param worker The index of the worker.
+       * @param workers The number of workers in this pool.
+       */
+      void work(unsigned int worker, unsigned int workers);
+
+      /**
+       * Start a batch of tasks and wait for it to finish.
+       *
+       * @param tasks The number of tasks to run.
+       * @param worker The worker to run every task on, or the number of workers to spread the tasks over all workers.
+       * @param task The function to run for each task.
+       */
+      void start(unsigned int tasks, unsigned int worker, const std::function<void(unsigned int, unsigned int)>& task);
+
+    public:
+      /**
+       * Construct a new pool of worker threads.
+       *
+       * @param threads The number of worker threads, or 0 to use one per hardware thread.
+       */
+      pool(unsigned int threads);
+
+      pool(const pool&) = delete;
+
+      pool& operator=(const pool&) = delete;
+
+      /**
+       * Stop and join the worker threads of this pool.
+       */
+      ~pool();
+
+      /**
+       * Get the number of worker threads in this pool.
+       *
+       * @return The number of worker threads in this pool.
+       */
+      unsigned int size() const;
+
+      /**
+       * Run a batch of tasks on the worker threads of this pool and wait for
+       * them to finish. Task `i` always runs on worker `i % size()`, such that
+       * tasks can own per-worker state. Several threads may run batches at
+       * once, in which case each worker runs its share of the batches in the
+       * order they were started, so batches overlap rather than wait for one
+       * another to finish. If any task throws, the first exception is
+       * rethrown once all tasks have finished.
+       *
+       * @param tasks The number of tasks to run.
+       * @param task The function to run for each task, given the index of the task and the index of the worker running it.
+       */
+      void run(unsigned int tasks, const std::function<void(unsigned int task, unsigned int worker)>& task);
+
+      /**
+       * Run a single task on one worker thread of this pool and wait for it to
+       * finish. Only the given worker is woken, so the other workers keep on
+       * running their own batches. If the task throws, the exception is
+       * rethrown.
+       *
+       * @param worker The index of the worker to run the task on.
+       * @param task The function to run.
+       */
+      void run_on(unsigned int worker, const std::function<void()>& task);
+  };
+}
@@ -0,0 +1,216 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <hemingway/vector.hpp>
+#include <hemingway/table.hpp>
+#include <hemingway/pool.hpp>
+
+namespace lsh {
+  /**
+   * A lookup table split into a number of independent shards. Vectors are
+   * assigned to shards by their hash, so that no single shard grows beyond a
+   * fraction of the vectors and rehashes stay small. Each shard is pinned to a
+   * worker thread, which is the only thread to touch it, so that inserts,
+   * erases, and queries may be made from several threads at once. Queries
+   * fan out to every shard and merge the results, and queries from several
+   * threads overlap on the workers rather than wait for one another. Each
+   * shard samples its own bits, or uses its own basis, drawn from the seed of
+   * the configuration it was constructed from.
+   *
+   * The id of a vector is its id within its shard times the number of shards,
+   * plus the index of the shard, and inserts that would push it to `UINT_MAX`
+   * are rejected.
+   */
+  class sharded_table {
+    private:
+      /**
+       * The shards holding the vectors.
+       */
+      std::vector<table> shards_;
+
+      /**
+       * The workers that the shards are pinned to, where shard `i` is pinned to
+       * worker `i`.
+       */
+      std::unique_ptr<pool> pool_;
+
+      /**
+       * Get the index of the shard that owns a vector.
+       *
+       * @param vector The vector.
+       * @return The index of the shard that owns the vector.
+       */
+      unsigned int shard(const vector_view& vector) const;
+
+      /**
+       * Translate a result of a shard into a result of this table.
+       *
+       * @param result The result of the shard.
+       * @param shard The index of the shard.
+       * @return The result with the id of the vector in this table.
+       */
+      table::result global(const table::result& result, unsigned int shard) const;
+
+      /**
+       * Insert a vector into a shard, on the worker of the shard.
+       *
+       * @param shard The index of the shard.
+       * @param vector The vector to insert into the shard.
+       * @return The id of the vector in this table.
+       */
+      unsigned int add(unsigned int shard, const vector_view& vector);
+
+      /**
+       * Construct a new sharded lookup table without any shards.
+       *
+       * @param shards The number of workers to pin shards to, or 0 to use one per hardware thread.
+       */
+      explicit sharded_table(unsigned int shards);
+
+    public:
+      /**
+       * Construct a new sharded lookup table of classic lookup tables. Each
+       * shard samples its own bits, seeded from the seed of the configuration.
+       *
+       * @param config The configuration parameters for the shards.
+       * @param shards The number of shards, or 0 to use one per hardware thread.
+       */
+      sharded_table(const table::classic& config, unsigned int shards = 0);
+
+      /**
+       * Construct a new sharded lookup table of covering lookup tables. Each
+       * shard uses its own basis, seeded from the seed of the configuration.
+       *
+       * @param config The configuration parameters for the shards.
+       * @param shards The number of shards, or 0 to use one per hardware thread.
+       */
+      sharded_table(const table::covering& config, unsigned int shards = 0);
+
+      /**
+       * Construct a new sharded lookup table of brute-force lookup tables.
+       *
+       * @param config The configuration parameters for the shards.
+       * @param shards The number of shards, or 0 to use one per hardware thread.
+       */
+      sharded_table(const table::brute& config, unsigned int shards = 0);
+
+      /**
+       * Get the number of shards in this lookup table.
+       *
+       * @return The number of shards in this lookup table.
+       */
+      unsigned int shards() const;
+
+      /**
+       * Get the number of vectors in this lookup table.
+       *
+       * @return The number of vectors in this lookup table.
+       */
+      unsigned int size() const;
+
+      /**
+       * Freeze the shards of this lookup table in parallel.
+       *
+       * @param compress Whether or not to compress the vector ids of the buckets.
+       */
+      void freeze(bool compress = false);
+
+      /**
+       * Insert a vector into the shard that owns it, on the worker of the
+       * shard.
+       *
+       * @param vector The vector to insert into this lookup table.
+       * @return The id of the vector, which stays the same until the vector is erased.
+       */
+      unsigned int insert(const vector_view& vector);
+
+      /**
+       * Insert a number of vectors into this lookup table, with each shard
+       * inserting the vectors it owns on its own worker. If any vector cannot
+       * be inserted, the vectors inserted so far are erased again before the
+       * exception is rethrown, leaving this lookup table as it was.
+       *
+       * @param vectors The vectors to insert into this lookup table.
+       * @param n The number of vectors.
+       * @return The ids of the vectors, in the order they were given.
+       */
+      std::vector<unsigned int> insert_batch(const vector* vectors, std::size_t n);
+
+      /**
+       * Erase a vector from the shard that owns it, on the worker of the
+       * shard.
+       *
+       * @param vector The vector to erase from this lookup table.
+       * @return `true` if the vector was found and erased, otherwise `false`.
+       */
+      bool erase(const vector_view& vector);
+
+      /**
+       * Erase the vector with a given id from this lookup table, on the worker
+       * of the shard holding it.
+       *
+       * @param id The id of the vector to erase from this lookup table.
+       * @return `true` if the vector was found and erased, otherwise `false`.
+       */
+      bool erase(unsigned int id);
+
+      /**
+       * Query every shard of this lookup table for the id of and distance to
+       * the nearest neighbour of a query vector.
+       *
+       * @param vector The query vector to look up the nearest neighbour of.
+       * @return The nearest neighbour if found, otherwise a result with an id and distance of `UINT_MAX`.
+       */
+      table::result query_nearest(const vector_view& vector) const;
+
+      /**
+       * Query every shard of this lookup table for the k nearest neighbours of
+       * a query vector.
+       *
+       * @param vector The query vector to look up the nearest neighbours of.
+       * @param k The number of nearest neighbours to look up.
+       * @return Up to k nearest neighbours found, ordered by increasing distance.
+       */
+      std::vector<table::result> query_k(const vector_view& vector, unsigned int k) const;
+
+      /**
+       * Query every shard of this lookup table for the neighbours of a query
+       * vector within a given distance.
+       *
+       * @param vector The query vector to look up the neighbours of.
+       * @param radius The distance within which to look up neighbours.
+       * @return The neighbours found within the distance, ordered by increasing distance.
+       */
+      std::vector<table::result> query_radius(const vector_view& vector, unsigned int radius) const;
+
+      /**
+       * Query every shard of this lookup table for any neighbour of a query
+       * vector within a given distance.
+       *
+       * @param vector The query vector to look up a neighbour of.
+       * @param radius The distance within which to look up a neighbour.
+       * @return A neighbour found within the distance, otherwise the nearest neighbour found.
+       */
+      table::result query_any(const vector_view& vector, unsigned int radius) const;
+
+      /**
+       * Query this lookup table for the nearest neighbours of a number of query
+       * vectors, with each shard answering every query on its own worker.
+       *
+       * @param vectors The query vectors to look up the nearest neighbours of.
+       * @param n The number of query vectors.
+       * @param results The array to write the result of each query to.
+       */
+      void query_batch(const vector* vectors, std::size_t n, table::result* results) const;
+
+      /**
+       * Compute a number of statistics for this lookup table, summed across
+       * its shards.
+       *
+       * @return The statistics computed for this lookup table.
+       */
+      table::statistics stats() const;
+  };
+}
@@ -3,28 +3,146 @@
 
 #include <stdexcept>
 #include <climits>
+#include <atomic>
+#include <algorithm>
 #include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <string>
 #include <vector>
 #include <unordered_map>
+#include <scoped_allocator>
+#include <hemingway/generator.hpp>
 #include <hemingway/vector.hpp>
+#include <hemingway/pool.hpp>
+#include <hemingway/memory.hpp>
 
 namespace lsh {
+  template <unsigned int Bits>
+  class basic_table;
+
   class table {
     private:
+      template <unsigned int Bits>
+      friend class basic_table;
+
       /**
        * A bucket containing candidate pairs.
        */
-      typedef std::vector<unsigned int> bucket;
+      typedef std::vector<unsigned int, allocator<unsigned int>> bucket;
+
+      /**
+       * A partition consisting of buckets. The allocator of the partition is
+       * passed on to its buckets, such that both allocate from the memory
+       * resource of the table.
+       */
+      typedef std::unordered_map<
+        std::uint64_t,
+        bucket,
+        std::hash<std::uint64_t>,
+        std::equal_to<std::uint64_t>,
+        std::scoped_allocator_adaptor<allocator<std::pair<const std::uint64_t, bucket>>>
+      > partition;
 
       /**
-       * A partition consisting of buckets.
+       * A partition that has been frozen into an open addressing table of keys,
+       * each pointing into a contiguous array of vector ids.
        */
-      typedef std::unordered_map<unsigned int, bucket> partition;
+      struct index {
+        /**
+         * The number of bits used for addressing the slots of the partition.
+         */
+        std::uint64_t bits;
+
+        /**
+         * The position of the first slot of the partition in the frozen keys.
+         */
+        std::uint64_t keys;
+
+        /**
+         * The position of the first slot of the partition in the frozen
+         * offsets.
+         */
+        std::uint64_t offsets;
+
+        /**
+         * The position of the first vector id of the partition in the frozen
+         * ids.
+         */
+        std::uint64_t ids;
+      };
 
       /**
-       * The next available vector id.
+       * The frozen partitions and vectors of a lookup table, laid out in one
+       * contiguous block of memory as page aligned sections. The block either
+       * lives on the heap or is mapped from a file saved by `table::save()`.
        */
-      unsigned int next_id_;
+      struct image {
+        /**
+         * The start of the block.
+         */
+        const char* data;
+
+        /**
+         * The number of bytes in the block.
+         */
+        std::size_t size;
+
+        /**
+         * The position of the partition indices in the block.
+         */
+        std::size_t partitions;
+
+        /**
+         * The position of the keys stored in the slots of every partition in
+         * the block.
+         */
+        std::size_t keys;
+
+        /**
+         * The position in the block of the offsets of the bucket of each slot
+         * of every partition into the ids of the partition, each partition
+         * followed by its number of ids. Empty slots have the same offset as
+         * the following slot.
+         */
+        std::size_t offsets;
+
+        /**
+         * The position of the vector ids of the buckets of every partition in
+         * the block.
+         */
+        std::size_t ids;
+
+        /**
+         * Whether or not the vector ids are compressed. Compressed buckets
+         * hold their number of ids as a varint followed by their ids in
+         * increasing order encoded using `kernel::encode()`, and the offsets
+         * and positions of the ids count bytes rather than ids.
+         */
+        bool compressed;
+
+        /**
+         * The position of the component chunks of the vectors in the block,
+         * laid out as in the vector arena.
+         */
+        std::size_t vectors;
+
+        /**
+         * The position of the weights of the vectors in the block, laid out as
+         * in the vector weights.
+         */
+        std::size_t weights;
+
+        /**
+         * The number of vector ids in the vector arena.
+         */
+        std::size_t capacity;
+
+        /**
+         * The owner of the block.
+         */
+        std::shared_ptr<const void> storage;
+      };
 
       /**
        * The number of dimensions of vectors in the table.
@@ -32,20 +150,259 @@ namespace lsh {
       unsigned int dimensions_;
 
       /**
-       * The vectors stored in this lookup table.
+       * The number of component chunks occupied by each vector in the table.
+       */
+      unsigned int stride_;
+
+      /**
+       * The number of vectors in the table.
+       */
+      unsigned int size_;
+
+      /**
+       * The component chunks of the vectors stored in this lookup table, laid
+       * out back to back with a fixed stride and indexed by vector id.
+       */
+      std::vector<kernel::word, allocator<kernel::word>> vectors_;
+
+      /**
+       * The number of bits set in each vector stored in this lookup table,
+       * indexed by vector id. The difference in weight between two vectors is
+       * a lower bound on their distance that is cheaper to check than the
+       * distance itself.
+       */
+      std::vector<unsigned int, allocator<unsigned int>> weights_;
+
+      /**
+       * The smallest weight of any vector inserted into this lookup table.
+       */
+      unsigned int lightest_;
+
+      /**
+       * The largest weight of any vector inserted into this lookup table.
+       */
+      unsigned int heaviest_;
+
+      /**
+       * Whether or not each vector id is currently in use.
+       */
+      std::vector<bool, allocator<bool>> used_;
+
+      /**
+       * The ids of erased vectors that are available for reuse.
+       */
+      std::vector<unsigned int, allocator<unsigned int>> free_;
+
+      /**
+       * The position of each vector id within its bucket in every partition,
+       * indexed by `id * partitions + partition`.
+       */
+      std::vector<unsigned int, allocator<unsigned int>> positions_;
+
+      /**
+       * The ids of the vectors in the table, indexed by the hash of their
+       * components.
+       */
+      std::unordered_multimap<
+        std::uint64_t,
+        unsigned int,
+        std::hash<std::uint64_t>,
+        std::equal_to<std::uint64_t>,
+        allocator<std::pair<const std::uint64_t, unsigned int>>
+      > index_;
+
+      /**
+       * The word masks used for sampling bits from vectors, grouped by
+       * partition.
+       */
+      std::vector<kernel::mask, allocator<kernel::mask>> samples_;
+
+      /**
+       * The offset of the first word mask of each partition in `samples_`,
+       * followed by the total number of word masks.
+       */
+      std::vector<unsigned int, allocator<unsigned int>> offsets_;
+
+      /**
+       * The number of bits sampled by each partition of a classic table.
+       */
+      std::vector<unsigned int, allocator<unsigned int>> widths_;
+
+      /**
+       * The number of extra buckets to probe in each partition of a classic
+       * table.
        */
-      std::unordered_map<unsigned int, vector> vectors_;
+      unsigned int probes_;
 
       /**
-       * The bit masks used for constructing vector projections.
+       * The basis vectors whose linear combinations form the bit masks used
+       * for constructing vector projections, stored back to back.
        */
-      std::vector<vector> masks_;
+      std::vector<kernel::word, allocator<kernel::word>> basis_;
 
       /**
        * The partitions containing the buckets of vectors.
        */
       std::vector<partition> partitions_;
 
+      /**
+       * The frozen partitions of the table, if the table has been frozen.
+       */
+      std::shared_ptr<const image> frozen_;
+
+      /**
+       * The number of bytes saved by freezing the table.
+       */
+      std::size_t saved_;
+
+      /**
+       * Add a partition that samples the bits set in a mask.
+       *
+       * @param mask The words of the mask.
+       */
+      void sample(const std::vector<kernel::word>& mask);
+
+      /**
+       * Compute the key of a projection spanning a number of chunks.
+       *
+       * @param projection The chunks of the projection.
+       * @param n The number of chunks.
+       * @return The key of the projection.
+       */
+      static std::uint64_t fold(const kernel::word* projection, unsigned int n);
+
+      /**
+       * Compute the keys of a vector in every partition.
+       *
+       * @param vector The chunks of the vector to compute the keys of.
+       * @param keys The array to write the key of each partition to.
+       */
+      void keys(const kernel::word* vector, std::uint64_t* keys) const;
+
+      /**
+       * Compute the bit masks of every partition of a covering table, stored
+       * back to back.
+       *
+       * @return The bit masks of every partition.
+       */
+      std::vector<kernel::word> masks() const;
+
+      /**
+       * Compute the key of a vector in a single partition.
+       *
+       * @param partition The index of the partition.
+       * @param vector The chunks of the vector to compute the key of.
+       * @param masks The bit masks of every partition of a covering table.
+       * @return The key of the vector in the partition.
+       */
+      std::uint64_t key(unsigned int partition, const kernel::word* vector, const kernel::word* masks) const;
+
+      /**
+       * Get the largest difference in weight between a vector of a given
+       * weight and any vector inserted into this lookup table.
+       *
+       * @param weight The weight of the vector.
+       * @return The largest difference in weight.
+       */
+      unsigned int spread(unsigned int weight) const;
+
+      /**
+       * Prefetch the slot of a key in a partition of this frozen lookup
+       * table, such that finding its bucket later hits the cache.
+       *
+       * @param partition The index of the partition.
+       * @param key The key whose slot to prefetch.
+       */
+      void prefetch(unsigned int partition, std::uint64_t key) const;
+
+      /**
+       * Find the bucket of a key in a partition.
+       *
+       * @param partition The index of the partition.
+       * @param key The key to find the bucket of.
+       * @param begin The first vector id of the bucket, if found.
+       * @param end One past the last vector id of the bucket, if found.
+       * @param buffer The buffer to decode the vector ids of a compressed bucket into, which the bucket then points into.
+       * @return `true` if the partition contains a bucket for the key, otherwise `false`.
+       */
+      bool find(unsigned int partition, std::uint64_t key, const unsigned int*& begin, const unsigned int*& end, std::vector<unsigned int>& buffer) const;
+
+      /**
+       * Remove a vector from the buckets of every partition of this lookup
+       * table and release its id.
+       *
+       * @param id The id of the vector to remove.
+       */
+      void remove(unsigned int id);
+
+      /**
+       * Estimate the number of bytes used by the partitions of this lookup table.
+       *
+       * @return The number of bytes used by the partitions of this lookup table.
+       */
+      std::size_t memory() const;
+
+      /**
+       * Get the component chunks of the vectors stored in this lookup table.
+       *
+       * @return The component chunks of the vectors, indexed by vector id.
+       */
+      const kernel::word* arena() const;
+
+      /**
+       * Get the weights of the vectors stored in this lookup table.
+       *
+       * @return The number of bits set in each vector, indexed by vector id.
+       */
+      const unsigned int* weights() const;
+
+      /**
+       * Get the number of vector ids in the vector arena of this lookup table.
+       *
+       * @return The number of vector ids in the vector arena.
+       */
+      std::size_t capacity() const;
+
+      /**
+       * Get the memory resource that this lookup table allocates from.
+       *
+       * @return The memory resource of this lookup table.
+       */
+      memory_resource* resource() const;
+
+      /**
+       * Construct an empty lookup table without any partitions, allocating
+       * from a memory resource.
+       *
+       * @param resource The memory resource to allocate from, or `nullptr` to use the heap.
+       */
+      explicit table(memory_resource* resource);
+
+      /**
+       * The number of bytes that the sections of frozen tables are aligned to.
+       */
+      static const std::size_t page = 4096;
+
+      /**
+       * Round a number of bytes up to a whole number of pages.
+       *
+       * @param n The number of bytes.
+       * @return The number of bytes rounded up to a whole number of pages.
+       */
+      static std::size_t align(std::size_t n);
+
+      /**
+       * Check that the sections of an image lie within it and that looking up
+       * keys in its partitions stays within its sections, such that a corrupt
+       * image cannot be read out of bounds.
+       *
+       * @param image The image to check.
+       * @param partitions The number of partitions in the image.
+       * @param stride The number of component chunks occupied by each vector.
+       * @return `true` if the image is consistent, otherwise `false`.
+       */
+      static bool check(const image& image, std::size_t partitions, std::size_t stride);
+
     public:
       struct classic {
         /**
@@ -62,6 +419,30 @@ namespace lsh {
          * The number of paritions to use.
          */
         const unsigned short partitions;
+
+        /**
+         * The number of extra buckets to probe in each partition when querying
+         * the table. These are the buckets whose keys differ from the key of
+         * the query in the fewest sampled bits, visited in order of the number
+         * of differing bits. Partitions that sample more than 64 bits are not
+         * probed beyond the bucket of the query.
+         */
+        const unsigned int probes = 0;
+
+        /**
+         * The seed of the generator used to sample the bits of each
+         * partition, drawn from a source of true randomness unless given.
+         * Tables constructed with the same seed sample the same bits.
+         */
+        const std::uint64_t seed = generator::entropy();
+
+        /**
+         * The memory resource to allocate the internals of the table from, or
+         * `nullptr` to use the heap. The resource must outlive the table
+         * along with any copy of it made once it was frozen, as such copies
+         * share its frozen partitions. Other copies use the heap.
+         */
+        memory_resource* const resource = nullptr;
       };
 
       struct covering {
@@ -74,6 +455,21 @@ namespace lsh {
          * The radius to cover in the table.
          */
         const unsigned short radius;
+
+        /**
+         * The seed of the generator used to construct the basis of the table,
+         * drawn from a source of true randomness unless given. Tables
+         * constructed with the same seed use the same basis.
+         */
+        const std::uint64_t seed = generator::entropy();
+
+        /**
+         * The memory resource to allocate the internals of the table from, or
+         * `nullptr` to use the heap. The resource must outlive the table
+         * along with any copy of it made once it was frozen, as such copies
+         * share its frozen partitions. Other copies use the heap.
+         */
+        memory_resource* const resource = nullptr;
       };
 
       struct brute {
@@ -81,6 +477,96 @@ namespace lsh {
          * The number of dimensions of vectors in the table.
          */
         const unsigned int dimensions;
+
+        /**
+         * The memory resource to allocate the internals of the table from, or
+         * `nullptr` to use the heap. The resource must outlive the table
+         * along with any copy of it made once it was frozen, as such copies
+         * share its frozen partitions. Other copies use the heap.
+         */
+        memory_resource* const resource = nullptr;
+      };
+
+      struct result {
+        /**
+         * The id of the nearest neighbour, or `UINT_MAX` if none was found.
+         */
+        unsigned int id;
+
+        /**
+         * The distance to the nearest neighbour, or `UINT_MAX` if none was found.
+         */
+        unsigned int distance;
+      };
+
+      /**
+       * Whether queries collect the detailed counters and timings that are
+       * compiled in with `HEMINGWAY_COUNTERS`.
+       */
+#ifdef HEMINGWAY_COUNTERS
+      static const bool counting = true;
+#else
+      static const bool counting = false;
+#endif
+
+      struct counters {
+        /**
+         * The number of candidates found in the probed buckets.
+         */
+        std::uint64_t candidates;
+
+        /**
+         * The number of candidates that had already been verified through
+         * another partition and were therefore skipped.
+         */
+        std::uint64_t duplicates;
+
+        /**
+         * The number of buckets probed across all partitions. Only collected
+         * when `table::counting` is set, as are the counters below.
+         */
+        std::uint64_t probes;
+
+        /**
+         * The number of probed buckets that turned out to be empty.
+         */
+        std::uint64_t misses;
+
+        /**
+         * The number of distances computed between the query and candidates.
+         */
+        std::uint64_t distances;
+
+        /**
+         * The number of candidates rejected for being too far away to matter,
+         * either because their weight differs too much from that of the query
+         * or because their distance reached the bound, in which case it may
+         * have been given up on part of the way through.
+         */
+        std::uint64_t pruned;
+
+        /**
+         * The number of nanoseconds spent computing the keys of the query.
+         */
+        std::uint64_t projection;
+
+        /**
+         * The number of nanoseconds spent looking up buckets.
+         */
+        std::uint64_t lookup;
+
+        /**
+         * The number of nanoseconds spent computing distances to candidates.
+         */
+        std::uint64_t verification;
+
+        /**
+         * Add the counters of another query or table to these counters.
+         *
+         * @param counters The counters to add.
+         * @return These counters.
+         */
+        counters& operator+=(const counters& counters);
       };
 
       struct statistics {
@@ -98,6 +584,63 @@ namespace lsh {
          * The total number of vectors in the table, counted across all buckets.
          */
         const unsigned int vectors;
+
+        /**
+         * The number of bytes used by the partitions of the table.
+         */
+        const std::size_t memory;
+
+        /**
+         * The number of bytes saved by freezing the table.
+         */
+        const std::size_t saved;
+
+        /**
+         * The number of buckets holding between 2^i and 2^(i+1) - 1 vectors,
+         * indexed by i.
+         */
+        const std::vector<unsigned int> histogram;
+
+        /**
+         * The number of vectors in the largest bucket of each partition.
+         */
+        const std::vector<unsigned int> largest;
+
+        /**
+         * The number of bytes used by the masks or basis vectors that keys
+         * are computed from.
+         */
+        const std::size_t mask_memory;
+
+        /**
+         * The number of bytes used by the stored vectors and their weights.
+         */
+        const std::size_t vector_memory;
+
+        /**
+         * The number of bytes used by the vector ids in the buckets of the
+         * table, which is less than the raw size if the table was frozen with
+         * compression.
+         */
+        const std::size_t id_memory;
+
+        /**
+         * The number of bytes that the vector ids in the buckets of the table
+         * take up as plain 32-bit ids.
+         */
+        const std::size_t raw_id_memory;
+
+        /**
+         * The number of queries run against the table. Only collected when
+         * `table::counting` is set.
+         */
+        const std::uint64_t queries;
+
+        /**
+         * The work done by all queries run against the table, summed. Only
+         * collected when `table::counting` is set.
+         */
+        const counters totals;
       };
 
       /**
@@ -128,19 +671,87 @@ namespace lsh {
        */
       unsigned int size() const;
 
+      /**
+       * Check if this lookup table has been frozen.
+       *
+       * @return `true` if this lookup table has been frozen, otherwise `false`.
+       */
+      bool frozen() const;
+
+      /**
+       * Freeze this lookup table, rewriting its partitions into compact arrays
+       * that are faster to query. A frozen table can no longer be modified.
+       *
+       * The vector ids of the buckets can optionally be compressed, at the
+       * cost of decoding each bucket as it is looked up. The ids of large
+       * buckets lie close together once sorted and shrink to well under half
+       * their size, whereas small buckets barely shrink at all.
+       *
+       * @param compress Whether or not to compress the vector ids of the buckets.
+       */
+      void freeze(bool compress = false);
+
+      /**
+       * Save this lookup table to a file that can later be opened using
+       * `table::open()`. The file stores the table in its frozen form; if this
+       * table has not been frozen, a frozen copy of it is saved instead.
+       *
+       * The file is written in the byte order of the host and can only be
+       * opened on hosts with the same byte order.
+       *
+       * @param path The path of the file to save the table to.
+       */
+      void save(const std::string& path) const;
+
+      /**
+       * Open a lookup table saved using `table::save()`. The file is mapped
+       * into memory and queries are served straight from the mapping, such
+       * that the table is paged in on demand and the pages are shared between
+       * all processes that open the same file. The layout of the file and
+       * the buckets of its partitions are checked before the table is opened,
+       * while the vectors are only read when queried. The opened table is
+       * frozen.
+       *
+       * @param path The path of the file to open.
+       * @return The opened lookup table.
+       */
+      static table open(const std::string& path);
+
       /**
        * Insert a vector into this lookup table.
        *
        * @param vector The vector to insert into this lookup table.
+       * @return The id of the vector, which stays the same until the vector is erased.
+       */
+      unsigned int insert(const vector_view& vector);
+
+      /**
+       * Insert a number of vectors into this lookup table using a number of
+       * worker threads. The partitions are filled in parallel and buckets are
+       * sized up front from the number of vectors that go into them.
+       *
+       * @param vectors The vectors to insert into this lookup table.
+       * @param n The number of vectors.
+       * @param threads The number of worker threads, or 0 to use one per hardware thread.
+       * @return The ids of the vectors, in the order they were given.
        */
-      void insert(const vector& vector);
+      std::vector<unsigned int> insert_batch(const vector* vectors, std::size_t n, unsigned int threads = 0);
 
       /**
        * Erase a vector from this lookup table.
        *
        * @param vector The vector to erase from this lookup table.
+       * @return `true` if the vector was found and erased, otherwise `false`.
+       */
+      bool erase(const vector_view& vector);
+
+      /**
+       * Erase the vector with a given id from this lookup table.
+       *
+       * @param id The id of the vector to erase from this lookup table.
+       * @return `true` if the vector was found and erased, otherwise `false`.
        */
-      void erase(const vector& vector);
+      bool erase(unsigned int id);
 
       /**
        * Query this lookup table for the nearest neighbour of a query vector.
@@ -148,7 +759,77 @@ namespace lsh {
        * @param vector The query vector to look up the nearest neighbour of.
        * @return The nearest neighbouring vector if found, otherwise a vector of size 0.
        */
-      vector query(const vector& vector) const;
+      vector query(const vector_view& vector) const;
+
+      /**
+       * Query this lookup table for the nearest neighbour of a query vector,
+       * recording what the query did.
+       *
+       * @param vector The query vector to look up the nearest neighbour of.
+       * @param counters The counters to record the work done by the query in.
+       * @return The nearest neighbouring vector if found, otherwise a vector of size 0.
+       */
+      vector query(const vector_view& vector, counters& counters) const;
+
+      /**
+       * Query this lookup table for the id of and distance to the nearest
+       * neighbour of a query vector, without copying the neighbour.
+       *
+       * @param vector The query vector to look up the nearest neighbour of.
+       * @return The nearest neighbour if found, otherwise a result with an id and distance of `UINT_MAX`.
+       */
+      result query_nearest(const vector_view& vector) const;
+
+      /**
+       * Query this lookup table for the k nearest neighbours of a query vector.
+       *
+       * @param vector The query vector to look up the nearest neighbours of.
+       * @param k The number of nearest neighbours to look up.
+       * @return Up to k nearest neighbours found, ordered by increasing distance.
+       */
+      std::vector<result> query_k(const vector_view& vector, unsigned int k) const;
+
+      /**
+       * Query this lookup table for the neighbours of a query vector within a
+       * given distance.
+       *
+       * @param vector The query vector to look up the neighbours of.
+       * @param radius The distance within which to look up neighbours.
+       * @return The neighbours found within the distance, ordered by increasing distance.
+       */
+      std::vector<result> query_radius(const vector_view& vector, unsigned int radius) const;
+
+      /**
+       * Query this lookup table for any neighbour of a query vector within a
+       * given distance, stopping as soon as one is found.
+       *
+       * @param vector The query vector to look up a neighbour of.
+       * @param radius The distance within which to look up a neighbour.
+       * @return The first neighbour found within the distance, otherwise the nearest neighbour found.
+       */
+      result query_any(const vector_view& vector, unsigned int radius) const;
+
+      /**
+       * Query this lookup table for the nearest neighbours of a number of query
+       * vectors, splitting the queries across the workers of a pool.
+       *
+       * @param vectors The query vectors to look up the nearest neighbours of.
+       * @param n The number of query vectors.
+       * @param results The array to write the result of each query to.
+       * @param pool The pool of workers to run the queries on.
+       */
+      void query_batch(const vector* vectors, std::size_t n, result* results, pool& pool) const;
+
+      /**
+       * Query this lookup table for the nearest neighbours of a number of query
+       * vectors using a number of worker threads.
+       *
+       * @param vectors The query vectors to look up the nearest neighbours of.
+       * @param n The number of query vectors.
+       * @param results The array to write the result of each query to.
+       * @param threads The number of worker threads, or 0 to use one per hardware thread.
+       */
+      void query_batch(const vector* vectors, std::size_t n, result* results, unsigned int threads = 0) const;
 
       /**
        * Compute a number of statistics for this lookup table.
@@ -156,5 +837,193 @@ namespace lsh {
        * @return The statistics computed for this lookup table.
        */
       statistics stats() const;
+
+    private:
+      /**
+       * The work done by queries against a table, summed across threads.
+       */
+      struct tally {
+        /**
+         * The number of queries.
+         */
+        std::atomic<std::uint64_t> queries;
+
+        /**
+         * The number of fields of `table::counters`.
+         */
+        static const std::size_t fields = sizeof(counters) / sizeof(std::uint64_t);
+
+        /**
+         * The sums of the counters of the queries, in the order of the fields
+         * of `table::counters`.
+         */
+        std::atomic<std::uint64_t> sums[fields];
+
+        /**
+         * Create an empty tally.
+         */
+        tally();
+
+        /**
+         * Create a copy of a tally.
+         *
+         * @param tally The tally to copy.
+         */
+        tally(const tally& tally);
+
+        /**
+         * Replace this tally with a copy of another.
+         *
+         * @param tally The tally to copy.
+         * @return This tally.
+         */
+        tally& operator=(const tally& tally);
+
+        /**
+         * Add the counters of a query to this tally.
+         *
+         * @param counters The counters of the query.
+         */
+        void add(const counters& counters);
+
+        /**
+         * Get the counters summed across all queries in this tally.
+         *
+         * @return The summed counters.
+         */
+        counters total() const;
+      };
+
+      /**
+       * The work done by queries against this table.
+       */
+      mutable tally totals_;
+
+      /**
+       * Insert the chunks of a vector of the size of this lookup table.
+       *
+       * @param vector The chunks of the vector to insert into this lookup table.
+       * @return The id of the vector, which stays the same until the vector is erased.
+       */
+      unsigned int add(const kernel::word* vector);
+
+      /**
+       * Insert the chunks of a number of vectors of the size of this lookup
+       * table using a number of worker threads.
+       *
+       * @param vectors The chunks of the vectors to insert into this lookup table.
+       * @param n The number of vectors.
+       * @param threads The number of worker threads, or 0 to use one per hardware thread.
+       * @return The ids of the vectors, in the order they were given.
+       */
+      std::vector<unsigned int> add_batch(const kernel::word* const* vectors, std::size_t n, unsigned int threads);
+
+      /**
+       * Erase the vector with the given chunks from this lookup table, which
+       * must be of the size of its vectors.
+       *
+       * @param vector The chunks of the vector to erase from this lookup table.
+       * @return `true` if the vector was found and erased, otherwise `false`.
+       */
+      bool discard(const kernel::word* vector);
+
+      /**
+       * Search this lookup table for the nearest neighbour of a query vector.
+       *
+       * @tparam N The number of chunks in vectors of this lookup table if fixed at compile time, otherwise 0.
+       * @param vector The chunks of the query vector.
+       * @param within The distance within which to stop probing partitions as soon as a candidate is found.
+       * @param counters The counters to record the work done by the query in, if any.
+       * @return The id of and distance to the nearest neighbour.
+       */
+      template <unsigned int N>
+      result search(const kernel::word* vector, unsigned int within = 0, counters* counters = nullptr) const;
+
+      /**
+       * Search this lookup table for the k nearest neighbours of a query
+       * vector.
+       *
+       * @tparam N The number of chunks in vectors of this lookup table if fixed at compile time, otherwise 0.
+       * @param vector The chunks of the query vector.
+       * @param k The number of nearest neighbours to look up.
+       * @return Up to k nearest neighbours found, ordered by increasing distance.
+       */
+      template <unsigned int N>
+      std::vector<result> search_k(const kernel::word* vector, unsigned int k) const;
+
+      /**
+       * Search this lookup table for the neighbours of a query vector within
+       * a given distance.
+       *
+       * @tparam N The number of chunks in vectors of this lookup table if fixed at compile time, otherwise 0.
+       * @param vector The chunks of the query vector.
+       * @param radius The distance within which to look up neighbours.
+       * @return The neighbours found within the distance, ordered by increasing distance.
+       */
+      template <unsigned int N>
+      std::vector<result> search_radius(const kernel::word* vector, unsigned int radius) const;
+
+      /**
+       * Search this lookup table for the nearest neighbours of a number of
+       * query vectors, splitting the queries across the workers of a pool.
+       *
+       * @tparam N The number of chunks in vectors of this lookup table if fixed at compile time, otherwise 0.
+       * @param vectors The chunks of the query vectors.
+       * @param n The number of query vectors.
+       * @param results The array to write the result of each query to.
+       * @param pool The pool of workers to run the queries on.
+       */
+      template <unsigned int N>
+      void search_batch(const kernel::word* const* vectors, std::size_t n, result* results, pool& pool) const;
+
+      /**
+       * Search this frozen lookup table for the nearest neighbours of a group
+       * of query vectors, interleaving the queries stage by stage such that
+       * their cache misses overlap.
+       *
+       * @tparam N The number of chunks in vectors of this lookup table if fixed at compile time, otherwise 0.
+       * @param vectors The chunks of the query vectors.
+       * @param n The number of query vectors, at most `group`.
+       * @param results The array to write the id of and distance to the nearest neighbour of each query to.
+       */
+      template <unsigned int N>
+      void search_group(const kernel::word* const* vectors, std::size_t n, result* results) const;
+
+      /**
+       * Visit each distinct candidate that collides with a query vector in
+       * any partition of this lookup table, until told to stop. Candidates
+       * at or beyond a bound are skipped, which lets most far away candidates
+       * be rejected without computing their full distance.
+       *
+       * @tparam N The number of chunks in vectors of this lookup table if fixed at compile time, otherwise 0.
+       * @param vector The chunks of the query vector.
+       * @param counters The counters to record the work done by the query in, if any.
+       * @param bound The distance from which candidates are skipped, which the visitor may lower as it goes.
+       * @param visit The function to call with the id of and distance to each candidate, returning `false` to stop probing partitions.
+       */
+      template <unsigned int N, typename F>
+      void scan(const kernel::word* vector, counters* counters, const unsigned int& bound, F visit) const;
+
+      /**
+       * Verify the candidates of a bucket against a query vector, visiting
+       * those that are closer than a bound. Candidates already visited by the
+       * query and candidates whose weight or distance reaches the bound are
+       * skipped.
+       *
+       * @tparam N The number of chunks in vectors of this lookup table if fixed at compile time, otherwise 0.
+       * @param vector The chunks of the query vector.
+       * @param weight The weight of the query vector.
+       * @param spread The largest difference in weight between the query vector and any vector in this table.
+       * @param stamp The stamp marking the candidates visited by the query.
+       * @param begin The first vector id of the bucket.
+       * @param end One past the last vector id of the bucket.
+       * @param bound The distance from which candidates are skipped, which the visitor may lower as it goes.
+       * @param ahead The number of candidates ahead whose vectors to prefetch, or 0 to not prefetch.
+       * @param counters The counters to record the work done in.
+       * @param visit The function to call with the id of and distance to each candidate, returning `false` to stop.
+       * @return `false` if the visitor asked to stop, otherwise `true`.
+       */
+      template <unsigned int N, typename F>
+      bool verify(const kernel::word* vector, unsigned int weight, unsigned int spread, unsigned int stamp, const unsigned int* begin, const unsigned int* end, const unsigned int& bound, unsigned int ahead, counters& counters, F visit) const;
   };
 }
@@ -0,0 +1,134 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <hemingway/generator.hpp>
+#include <hemingway/vector.hpp>
+#include <hemingway/table.hpp>
+
+namespace lsh {
+  /**
+   * Picks the configuration of a lookup table from a sample of the data it
+   * will hold. Part of the sample is held out as queries, and candidate tables
+   * built from the rest are measured on the held-out queries that have a
+   * neighbour within the target radius. The cheapest configuration that finds
+   * such a neighbour for at least the target fraction of queries wins.
+   */
+  class tuner {
+    public:
+      struct estimate {
+        /**
+         * The fraction of queries for which a neighbour within the radius was
+         * found.
+         */
+        const double recall;
+
+        /**
+         * The average number of buckets probed and distances computed per
+         * query.
+         */
+        const double cost;
+      };
+
+    private:
+      /**
+       * The number of dimensions of the sampled vectors.
+       */
+      unsigned int dimensions_;
+
+      /**
+       * The radius within which queries should find a neighbour.
+       */
+      unsigned int radius_;
+
+      /**
+       * The fraction of queries that should find a neighbour.
+       */
+      double recall_;
+
+      /**
+       * The seed of the candidate tables.
+       */
+      std::uint64_t seed_;
+
+      /**
+       * The vectors of the sample that candidate tables are built from.
+       */
+      std::vector<vector> vectors_;
+
+      /**
+       * The held-out vectors of the sample that have a neighbour within the
+       * radius among the other vectors.
+       */
+      std::vector<vector> queries_;
+
+      /**
+       * Fill a table with the sample and measure it on the held-out queries.
+       *
+       * @param table The empty table to measure.
+       * @param probes The number of buckets probed per query.
+       * @return The estimated recall and cost of the table.
+       */
+      estimate measure(table& table, unsigned int probes) const;
+
+    public:
+      /**
+       * Construct a new tuner.
+       *
+       * @param sample A sample of the vectors that tables will hold.
+       * @param radius The radius within which queries should find a neighbour, at most 12.
+       * @param recall The fraction of queries that should find a neighbour.
+       * @param queries The number of vectors to hold out as queries, or 0 to hold out a tenth of the sample.
+       * @param seed The seed of the candidate tables, which is drawn from a source of true randomness unless given.
+       */
+      tuner(const std::vector<vector>& sample, unsigned int radius, double recall, unsigned int queries = 0, std::uint64_t seed = generator::entropy());
+
+      /**
+       * Measure a classic configuration on the held-out queries.
+       *
+       * @param config The configuration to measure.
+       * @return The estimated recall and cost of the configuration.
+       */
+      estimate measure(const table::classic& config) const;
+
+      /**
+       * Measure a covering configuration on the held-out queries.
+       *
+       * @param config The configuration to measure.
+       * @return The estimated recall and cost of the configuration.
+       */
+      estimate measure(const table::covering& config) const;
+
+      /**
+       * Find the cheapest classic configuration that meets the recall target.
+       * The configuration uses the seed of the tuner, such that tables
+       * constructed from it are the ones that were measured.
+       *
+       * @param cost The place to store the estimated cost of the configuration, if any.
+       * @return The cheapest classic configuration found.
+       */
+      table::classic classic(double* cost = nullptr) const;
+
+      /**
+       * Find the cheapest covering configuration that meets the recall
+       * target. Covering the full radius always meets it, but covering a
+       * smaller radius may be cheaper and still meet it. The configuration
+       * uses the seed of the tuner, such that tables constructed from it are
+       * the ones that were measured.
+       *
+       * @param cost The place to store the estimated cost of the configuration, if any.
+       * @return The cheapest covering configuration found.
+       */
+      table::covering covering(double* cost = nullptr) const;
+
+      /**
+       * Construct an empty lookup table using the cheapest configuration of
+       * either scheme that meets the recall target. Tuners constructed with
+       * the same sample and seed construct the same table.
+       *
+       * @return The lookup table.
+       */
+      table tune() const;
+  };
+}
@@ -5,14 +5,22 @@
 #include <string>
 #include <vector>
 #include <random>
+#include <cstdint>
+#include <hemingway/kernel.hpp>
+#include <hemingway/generator.hpp>
+#include <hemingway/vector_view.hpp>
 
 namespace lsh {
+  class table;
+
   class vector {
+    friend class table;
+
     private:
       /**
        * The size of component chunks.
        */
-      static const unsigned int chunk_size_ = sizeof(unsigned int) * 8;
+      static const unsigned int chunk_size_ = sizeof(kernel::word) * 8;
 
       /**
        * The number of components in this vector.
@@ -22,7 +30,7 @@ namespace lsh {
       /**
        * The chunked components of this vector.
        */
-      std::vector<unsigned int> components_;
+      std::vector<kernel::word> components_;
 
       /**
        * Create a new vector from existing component chunks.
@@ -30,7 +38,7 @@ namespace lsh {
        * @param components The existing component chunks.
        * @param size The number of components.
        */
-      vector(const std::vector<unsigned int>& components, unsigned int size);
+      vector(const std::vector<kernel::word>& components, unsigned int size);
 
     public:
       /**
@@ -40,6 +48,40 @@ namespace lsh {
        */
       vector(const std::vector<bool>& components);
 
+      /**
+       * Create a new vector from components packed into words, using the
+       * layout described by `lsh::vector_view`. Unused bits of a last partial
+       * word are ignored.
+       *
+       * @param components The words holding the components.
+       * @param size The number of components.
+       */
+      vector(const kernel::word* components, unsigned int size);
+
+      /**
+       * Create a new vector from components packed into bytes, most
+       * significant bit first, as they would arrive from the network.
+       *
+       * @param components The bytes holding the components.
+       * @param size The number of components.
+       */
+      vector(const std::uint8_t* components, unsigned int size);
+
+      /**
+       * Create a new vector holding a copy of the components of a view.
+       *
+       * @param vector The view to copy.
+       */
+      explicit vector(const vector_view& vector);
+
+      /**
+       * Get a view of the components of this vector. The view is invalidated
+       * when the vector is destroyed.
+       *
+       * @return A view of the components of this vector.
+       */
+      operator vector_view() const;
+
       /**
        * Get the number of components in this vector.
        *
@@ -92,7 +134,7 @@ namespace lsh {
        * @param vector The other vector.
        * @return The bitwise AND of this and another vector.
        */
-      vector operator&(const vector& vector) const;
+      vector operator&(const vector_view& vector) const;
 
       /**
        * Compupte the hash of this vector.
@@ -104,13 +146,11 @@ namespace lsh {
       /**
        * Compute the distance between two vectors.
        *
-       * @see http://graphics.stanford.edu/~seander/bithacks.html#CountBitsSetKernighan
-       *
        * @param u The first vector.
        * @param v The second vector.
        * @return The distance between the two vectors.
        */
-      static unsigned int distance(const vector& u, const vector& v);
+      static unsigned int distance(const vector_view& u, const vector_view& v);
 
       /**
        * Construct a random vector of a given dimensionality.
@@ -119,5 +159,25 @@ namespace lsh {
        * @return The randomly generated vector.
        */
       static vector random(unsigned int dimensions);
+
+      /**
+       * Construct a random vector of a given dimensionality, drawing its
+       * components a word at a time from a generator.
+       *
+       * @param dimensions The number of dimensions in the vector.
+       * @param generator The generator to draw the components from.
+       * @return The randomly generated vector.
+       */
+      static vector random(unsigned int dimensions, generator& generator);
+
+      /**
+       * Construct a number of random vectors of a given dimensionality.
+       *
+       * @param dimensions The number of dimensions in the vectors.
+       * @param n The number of vectors.
+       * @param generator The generator to draw the components from.
+       * @return The randomly generated vectors.
+       */
+      static std::vector<vector> random_batch(unsigned int dimensions, std::size_t n, generator& generator);
   };
 }
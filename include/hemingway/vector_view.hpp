@@ -0,0 +1,83 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#pragma once
+
+#include <stdexcept>
+#include <hemingway/kernel.hpp>
+
+namespace lsh {
+  class vector;
+
+  /**
+   * A non-owning view of a vector whose components are packed into words held
+   * by the caller. Components are packed most significant bit first, 64 to a
+   * word, with the components of a last partial word right-aligned and its
+   * unused high bits cleared. This is the layout used by `lsh::vector`.
+   */
+  class vector_view {
+    private:
+      /**
+       * The words holding the components of the viewed vector.
+       */
+      const kernel::word* components_;
+
+      /**
+       * The number of components in the viewed vector.
+       */
+      unsigned int size_;
+
+    public:
+      /**
+       * Create a new view of packed components. The words must outlive the
+       * view.
+       *
+       * @param components The words holding the components.
+       * @param size The number of components.
+       */
+      vector_view(const kernel::word* components, unsigned int size);
+
+      /**
+       * Get the number of components in the viewed vector.
+       *
+       * @return The number of components in the viewed vector.
+       */
+      unsigned int size() const;
+
+      /**
+       * Get the number of words holding the components of the viewed vector.
+       *
+       * @return The number of words holding the components.
+       */
+      unsigned int chunks() const;
+
+      /**
+       * Get the words holding the components of the viewed vector.
+       *
+       * @return The words holding the components.
+       */
+      const kernel::word* data() const;
+
+      /**
+       * Get the component at the specified index of the viewed vector.
+       *
+       * @param index The index of the component to get.
+       * @return The component at the index.
+       */
+      bool get(unsigned int index) const;
+
+      /**
+       * Compute the bitwise AND of the viewed vector and another vector.
+       *
+       * @param vector The other vector.
+       * @return The bitwise AND of the two vectors.
+       */
+      vector operator&(const vector_view& vector) const;
+
+      /**
+       * Compute the hash of the viewed vector. The hash equals that of an
+       * `lsh::vector` with the same components.
+       *
+       * @return The hash of the viewed vector.
+       */
+      unsigned int hash() const;
+  };
+}
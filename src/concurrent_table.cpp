@@ -0,0 +1,219 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <atomic>
+#include <thread>
+#include <hemingway/concurrent_table.hpp>
+
+namespace lsh {
+  /**
+   * The source of the lock stripe slots handed out to threads.
+   */
+  static std::atomic<unsigned int> slots(0);
+
+  /**
+   * The lock stripe slot of the calling thread, assigned round robin on first
+   * use such that concurrent readers spread evenly across stripes.
+   */
+  static thread_local unsigned int slot = slots++;
+
+  /**
+   * Lock every stripe of a table.
+   *
+   * @param table The table to lock.
+   */
+  concurrent_table::exclusive::exclusive(const concurrent_table& t): table_(t) {
+    // Announce the writer before taking the gate, such that readers arriving
+    // from now on queue up behind it instead of taking their stripes.
+    t.writers_++;
+    t.gate_.lock();
+
+    for (unsigned int i = 0; i < t.stripes_; i++) {
+      t.locks_[i].mutex.lock();
+    }
+  }
+
+  /**
+   * Unlock every stripe of the table.
+   */
+  concurrent_table::exclusive::~exclusive() {
+    for (unsigned int i = this->table_.stripes_; i-- > 0;) {
+      this->table_.locks_[i].mutex.unlock();
+    }
+
+    this->table_.writers_--;
+    this->table_.gate_.unlock();
+  }
+
+  /**
+   * Get the lock stripe of the calling thread, first waiting for any writers
+   * that are waiting for or holding the lock stripes.
+   *
+   * @return The mutex of the lock stripe of the calling thread.
+   */
+  std::mutex& concurrent_table::shared() const {
+    // Readers only touch the gate while writers are around, such that they
+    // keep to their own stripes otherwise.
+    if (this->writers_.load() != 0) {
+      std::lock_guard<std::mutex> lock(this->gate_);
+    }
+
+    return this->locks_[slot % this->stripes_].mutex;
+  }
+
+  /**
+   * Construct a new concurrent lookup table.
+   *
+   * @param table The lookup table to make concurrent.
+   * @param stripes The number of lock stripes, or 0 to use one per hardware thread.
+   */
+  concurrent_table::concurrent_table(const table& t, unsigned int s): table_(t), writers_(0) {
+    if (s == 0) {
+      s = std::thread::hardware_concurrency();
+    }
+
+    if (s == 0) {
+      s = 1;
+    }
+
+    this->stripes_ = s;
+    this->locks_.reset(new stripe[s]);
+  }
+
+  /**
+   * Get the number of vectors in this lookup table.
+   *
+   * @return The number of vectors in this lookup table.
+   */
+  unsigned int concurrent_table::size() const {
+    std::lock_guard<std::mutex> lock(this->shared());
+
+    return this->table_.size();
+  }
+
+  /**
+   * Insert a vector into this lookup table.
+   *
+   * @param vector The vector to insert into this lookup table.
+   * @return The id of the vector, which stays the same until the vector is erased.
+   */
+  unsigned int concurrent_table::insert(const vector_view& v) {
+    exclusive lock(*this);
+
+    return this->table_.insert(v);
+  }
+
+  /**
+   * Insert a number of vectors into this lookup table at once, holding off
+   * readers only once for the whole batch.
+   *
+   * @param vectors The vectors to insert into this lookup table.
+   * @param n The number of vectors.
+   * @param threads The number of worker threads, or 0 to use one per hardware thread.
+   * @return The ids of the vectors, in the order they were given.
+   */
+  std::vector<unsigned int> concurrent_table::insert_batch(const vector* vs, std::size_t n, unsigned int t) {
+    exclusive lock(*this);
+
+    return this->table_.insert_batch(vs, n, t);
+  }
+
+  /**
+   * Erase a vector from this lookup table.
+   *
+   * @param vector The vector to erase from this lookup table.
+   * @return `true` if the vector was found and erased, otherwise `false`.
+   */
+  bool concurrent_table::erase(const vector_view& v) {
+    exclusive lock(*this);
+
+    return this->table_.erase(v);
+  }
+
+  /**
+   * Erase the vector with a given id from this lookup table.
+   *
+   * @param id The id of the vector to erase from this lookup table.
+   * @return `true` if the vector was found and erased, otherwise `false`.
+   */
+  bool concurrent_table::erase(unsigned int id) {
+    exclusive lock(*this);
+
+    return this->table_.erase(id);
+  }
+
+  /**
+   * Query this lookup table for the nearest neighbour of a query vector.
+   *
+   * @param vector The query vector to look up the nearest neighbour of.
+   * @return The nearest neighbouring vector if found, otherwise a vector of size 0.
+   */
+  vector concurrent_table::query(const vector_view& v) const {
+    std::lock_guard<std::mutex> lock(this->shared());
+
+    return this->table_.query(v);
+  }
+
+  /**
+   * Query this lookup table for the id of and distance to the nearest
+   * neighbour of a query vector.
+   *
+   * @param vector The query vector to look up the nearest neighbour of.
+   * @return The nearest neighbour if found, otherwise a result with an id and distance of `UINT_MAX`.
+   */
+  table::result concurrent_table::query_nearest(const vector_view& v) const {
+    std::lock_guard<std::mutex> lock(this->shared());
+
+    return this->table_.query_nearest(v);
+  }
+
+  /**
+   * Query this lookup table for the k nearest neighbours of a query vector.
+   *
+   * @param vector The query vector to look up the nearest neighbours of.
+   * @param k The number of nearest neighbours to look up.
+   * @return Up to k nearest neighbours found, ordered by increasing distance.
+   */
+  std::vector<table::result> concurrent_table::query_k(const vector_view& v, unsigned int k) const {
+    std::lock_guard<std::mutex> lock(this->shared());
+
+    return this->table_.query_k(v, k);
+  }
+
+  /**
+   * Query this lookup table for the neighbours of a query vector within a
+   * given distance.
+   *
+   * @param vector The query vector to look up the neighbours of.
+   * @param radius The distance within which to look up neighbours.
+   * @return The neighbours found within the distance, ordered by increasing distance.
+   */
+  std::vector<table::result> concurrent_table::query_radius(const vector_view& v, unsigned int r) const {
+    std::lock_guard<std::mutex> lock(this->shared());
+
+    return this->table_.query_radius(v, r);
+  }
+
+  /**
+   * Query this lookup table for any neighbour of a query vector within a given
+   * distance, stopping as soon as one is found.
+   *
+   * @param vector The query vector to look up a neighbour of.
+   * @param radius The distance within which to look up a neighbour.
+   * @return The first neighbour found within the distance, otherwise the nearest neighbour found.
+   */
+  table::result concurrent_table::query_any(const vector_view& v, unsigned int r) const {
+    std::lock_guard<std::mutex> lock(this->shared());
+
+    return this->table_.query_any(v, r);
+  }
+
+  /**
+   * Compute a number of statistics for this lookup table.
+   *
+   * @return The statistics computed for this lookup table.
+   */
+  table::statistics concurrent_table::stats() const {
+    std::lock_guard<std::mutex> lock(this->shared());
+
+    return this->table_.stats();
+  }
+}
@@ -0,0 +1,37 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <random>
+#include <hemingway/generator.hpp>
+
+namespace lsh {
+  /**
+   * Draw a seed from a source of true randomness.
+   *
+   * @return The seed.
+   */
+  std::uint64_t generator::entropy() {
+    std::random_device random;
+
+    return std::uint64_t(random()) << 32 | random();
+  }
+
+  /**
+   * Construct a new generator seeded from a source of true randomness.
+   */
+  generator::generator(): generator(entropy()) {}
+
+  /**
+   * Construct a new generator from a seed.
+   *
+   * @param seed The seed, which is expanded into the state of the generator using splitmix64.
+   */
+  generator::generator(std::uint64_t s) {
+    for (std::uint64_t& x: this->state_) {
+      std::uint64_t z = (s += 0x9e3779b97f4a7c15);
+
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+
+      x = z ^ (z >> 31);
+    }
+  }
+}
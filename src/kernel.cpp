@@ -0,0 +1,888 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <atomic>
+#include <algorithm>
+#include <hemingway/kernel.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HEMINGWAY_X86
+#include <immintrin.h>
+#endif
+
+namespace lsh {
+  namespace kernel {
+    /**
+     * The kernels implemented for a single instruction set.
+     */
+    struct kernels {
+      /**
+       * The Hamming distance kernel.
+       */
+      unsigned int (*distance)(const word*, const word*, unsigned int);
+
+      /**
+       * The bounded Hamming distance kernel.
+       */
+      unsigned int (*bounded)(const word*, const word*, unsigned int, unsigned int);
+
+      /**
+       * The one-to-many Hamming distance kernel.
+       */
+      void (*distances)(const word*, const word*, unsigned int, unsigned int, unsigned int*);
+
+      /**
+       * The dot product kernel.
+       */
+      unsigned int (*dot)(const word*, const word*, unsigned int);
+
+      /**
+       * The bit extraction kernel.
+       */
+      word (*extract)(const word*, const mask*, unsigned int);
+
+      /**
+       * The id decoding kernel.
+       */
+      std::size_t (*decode)(const std::uint8_t*, unsigned int, unsigned int*);
+    };
+
+    /**
+     * The number of words compared between checks of a bounded distance
+     * against its bound, which spans one cache line of each vector. The
+     * bounded kernels unroll their blocks by hand to match.
+     */
+    static const unsigned int block = 8;
+
+    /**
+     * Count the number of bits set in a word without relying on hardware
+     * support.
+     *
+     * @see http://graphics.stanford.edu/~seander/bithacks.html#CountBitsSetParallel
+     *
+     * @param x The word to count the bits of.
+     * @return The number of bits set in the word.
+     */
+    static inline unsigned int popcount(word x) {
+      x = x - ((x >> 1) & 0x5555555555555555);
+      x = (x & 0x3333333333333333) + ((x >> 2) & 0x3333333333333333);
+      x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0f;
+
+      return (x * 0x0101010101010101) >> 56;
+    }
+
+    /**
+     * Count the bits set in either the XOR (`X = true`) or the AND
+     * (`X = false`) of two sequences of words using portable code.
+     */
+    template <bool X>
+    static unsigned int count_generic(const word* u, const word* v, unsigned int n) {
+      unsigned int d = 0;
+
+      for (unsigned int i = 0; i < n; i++) {
+        d += popcount(X ? u[i] ^ v[i] : u[i] & v[i]);
+      }
+
+      return d;
+    }
+
+    /**
+     * Compute a bounded Hamming distance using portable code, checking the
+     * distance against the bound after every block of words.
+     */
+    static unsigned int bounded_generic(const word* u, const word* v, unsigned int n, unsigned int b) {
+      unsigned int i = 0;
+      unsigned int d = 0;
+
+      for (; i + block <= n; i += block) {
+        const word* a = u + i;
+        const word* c = v + i;
+
+        d += popcount(a[0] ^ c[0]) + popcount(a[1] ^ c[1])
+           + popcount(a[2] ^ c[2]) + popcount(a[3] ^ c[3])
+           + popcount(a[4] ^ c[4]) + popcount(a[5] ^ c[5])
+           + popcount(a[6] ^ c[6]) + popcount(a[7] ^ c[7]);
+
+        if (d >= b) {
+          return d;
+        }
+      }
+
+      for (; i < n; i++) {
+        d += popcount(u[i] ^ v[i]);
+      }
+
+      return d;
+    }
+
+    /**
+     * Append a number of extracted bits to a key.
+     *
+     * @param k The key to append to.
+     * @param e The extracted bits.
+     * @param c The number of extracted bits.
+     * @return The key with the extracted bits appended.
+     */
+    static inline word append(word k, word e, unsigned int c) {
+      return ((k << (c & 63)) | (k >> ((64 - c) & 63))) ^ e;
+    }
+
+    /**
+     * Gather the bits selected by a sequence of masks using portable code.
+     */
+    static word extract_generic(const word* v, const mask* ms, unsigned int n) {
+      word k = 0;
+
+      for (unsigned int i = 0; i < n; i++) {
+        word x = v[ms[i].index];
+        word e = 0;
+        unsigned int c = 0;
+
+        for (word m = ms[i].bits; m != 0; m &= m - 1) {
+          e |= word((x & m & -m) != 0) << c++;
+        }
+
+        k = append(k, e, c);
+      }
+
+      return k;
+    }
+
+    /**
+     * Compute one-to-many Hamming distances using a given distance kernel.
+     */
+    template <unsigned int (*F)(const word*, const word*, unsigned int)>
+    static void distances_each(const word* u, const word* vs, unsigned int n, unsigned int m, unsigned int* ds) {
+      for (unsigned int i = 0; i < m; i++) {
+        ds[i] = F(u, vs + i * n, n);
+      }
+    }
+
+    /**
+     * Decode the ids of an encoded sequence from a given position on using
+     * portable code.
+     *
+     * @param c The control bytes of the sequence.
+     * @param d The bytes of the difference at the position.
+     * @param i The position to decode from.
+     * @param n The number of ids in the sequence.
+     * @param l The id before the position, or 0 at the start.
+     * @param ids The array to write the decoded ids of the sequence to.
+     * @return One past the last byte read.
+     */
+    static const std::uint8_t* decode_from(const std::uint8_t* c, const std::uint8_t* d, unsigned int i, unsigned int n, unsigned int l, unsigned int* ids) {
+      for (; i < n; i++) {
+        unsigned int b = ((c[i / 4] >> (2 * (i % 4))) & 3) + 1;
+        unsigned int x = 0;
+
+        for (unsigned int j = 0; j < b; j++) {
+          x |= (unsigned int) *d++ << (8 * j);
+        }
+
+        ids[i] = l += x;
+      }
+
+      return d;
+    }
+
+    /**
+     * Decode a sequence of ids using portable code.
+     */
+    static std::size_t decode_generic(const std::uint8_t* in, unsigned int n, unsigned int* ids) {
+      return decode_from(in, in + (n + 3) / 4, 0, n, 0, ids) - in;
+    }
+
+#ifdef HEMINGWAY_X86
+    /**
+     * The shuffles that spread the bytes of four encoded differences out into
+     * four 32-bit lanes, along with the number of bytes they span, indexed by
+     * control byte.
+     */
+    struct shuffles {
+      std::uint8_t masks[256][16];
+      std::uint8_t lengths[256];
+
+      shuffles() {
+        for (unsigned int c = 0; c < 256; c++) {
+          unsigned int o = 0;
+
+          for (unsigned int i = 0; i < 4; i++) {
+            unsigned int b = ((c >> (2 * i)) & 3) + 1;
+
+            for (unsigned int j = 0; j < 4; j++) {
+              this->masks[c][4 * i + j] = j < b ? o + j : 0xff;
+            }
+
+            o += b;
+          }
+
+          this->lengths[c] = o;
+        }
+      }
+    };
+
+    /**
+     * Decode a sequence of ids using SSSE3. Each control byte selects the
+     * shuffle that spreads four differences out into lanes, after which a
+     * prefix sum across the lanes turns them back into ids.
+     *
+     * @see https://arxiv.org/abs/1709.08990
+     */
+    __attribute__((target("ssse3")))
+    static std::size_t decode_ssse3(const std::uint8_t* in, unsigned int n, unsigned int* ids) {
+      static const shuffles s;
+
+      const std::uint8_t* d = in + (n + 3) / 4;
+
+      __m128i l = _mm_setzero_si128();
+
+      unsigned int i = 0;
+
+      for (; i + 4 <= n; i += 4) {
+        std::uint8_t c = in[i / 4];
+
+        __m128i m = _mm_loadu_si128((const __m128i*) s.masks[c]);
+        __m128i x = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) d), m);
+
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, l);
+
+        _mm_storeu_si128((__m128i*) (ids + i), x);
+
+        l = _mm_shuffle_epi32(x, 0xff);
+        d += s.lengths[c];
+      }
+
+      return decode_from(in, d, i, n, _mm_cvtsi128_si32(l), ids) - in;
+    }
+
+    /**
+     * Count the bits set in either the XOR or the AND of two sequences of words
+     * using the POPCNT instruction.
+     */
+    template <bool X>
+    __attribute__((target("popcnt")))
+    static unsigned int count_popcnt(const word* u, const word* v, unsigned int n) {
+      unsigned int d = 0;
+
+      for (unsigned int i = 0; i < n; i++) {
+        d += __builtin_popcountll(X ? u[i] ^ v[i] : u[i] & v[i]);
+      }
+
+      return d;
+    }
+
+    /**
+     * Compute a bounded Hamming distance using the POPCNT instruction, checking
+     * the distance against the bound after every block of words.
+     */
+    __attribute__((target("popcnt")))
+    static unsigned int bounded_popcnt(const word* u, const word* v, unsigned int n, unsigned int b) {
+      unsigned int i = 0;
+      unsigned int d = 0;
+
+      for (; i + block <= n; i += block) {
+        const word* a = u + i;
+        const word* c = v + i;
+
+        d += __builtin_popcountll(a[0] ^ c[0]) + __builtin_popcountll(a[1] ^ c[1])
+           + __builtin_popcountll(a[2] ^ c[2]) + __builtin_popcountll(a[3] ^ c[3])
+           + __builtin_popcountll(a[4] ^ c[4]) + __builtin_popcountll(a[5] ^ c[5])
+           + __builtin_popcountll(a[6] ^ c[6]) + __builtin_popcountll(a[7] ^ c[7]);
+
+        if (d >= b) {
+          return d;
+        }
+      }
+
+      for (; i < n; i++) {
+        d += __builtin_popcountll(u[i] ^ v[i]);
+      }
+
+      return d;
+    }
+
+    /**
+     * Count the bits set in each byte of a 256-bit register using a nibble
+     * lookup table.
+     *
+     * @see https://arxiv.org/abs/1611.07612
+     */
+    __attribute__((target("avx2")))
+    static inline __m256i bytes_avx2(__m256i x) {
+      const __m256i t = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+      );
+
+      const __m256i m = _mm256_set1_epi8(0x0f);
+
+      __m256i l = _mm256_shuffle_epi8(t, _mm256_and_si256(x, m));
+      __m256i h = _mm256_shuffle_epi8(t, _mm256_and_si256(_mm256_srli_epi16(x, 4), m));
+
+      return _mm256_add_epi8(l, h);
+    }
+
+    /**
+     * Count the bits set in each byte of a 256-bit register, summed into four
+     * 64-bit lanes.
+     */
+    __attribute__((target("avx2")))
+    static inline __m256i popcount_avx2(__m256i x) {
+      return _mm256_sad_epu8(bytes_avx2(x), _mm256_setzero_si256());
+    }
+
+    /**
+     * Add three 256-bit registers using a carry-save adder.
+     */
+    __attribute__((target("avx2")))
+    static inline void csa_avx2(__m256i& h, __m256i& l, __m256i a, __m256i b, __m256i c) {
+      __m256i u = _mm256_xor_si256(a, b);
+
+      h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+      l = _mm256_xor_si256(u, c);
+    }
+
+    /**
+     * Load four words from each of two sequences and combine them.
+     */
+    template <bool X>
+    __attribute__((target("avx2")))
+    static inline __m256i load_avx2(const word* u, const word* v) {
+      __m256i a = _mm256_loadu_si256((const __m256i*) u);
+      __m256i b = _mm256_loadu_si256((const __m256i*) v);
+
+      return X ? _mm256_xor_si256(a, b) : _mm256_and_si256(a, b);
+    }
+
+    /**
+     * Count the bits set in either the XOR or the AND of two sequences of words
+     * using AVX2. Blocks of 64 words go through a Harley-Seal carry-save adder
+     * network, remaining blocks of 4 words through the nibble lookup table and
+     * the remaining words through POPCNT.
+     *
+     * @see https://arxiv.org/abs/1611.07612
+     */
+    template <bool X>
+    __attribute__((target("avx2,popcnt")))
+    static unsigned int count_avx2(const word* u, const word* v, unsigned int n) {
+      unsigned int i = 0;
+
+      __m256i t = _mm256_setzero_si256();
+
+      if (n >= 64) {
+        __m256i ones = _mm256_setzero_si256();
+        __m256i twos = _mm256_setzero_si256();
+        __m256i fours = _mm256_setzero_si256();
+        __m256i eights = _mm256_setzero_si256();
+        __m256i sixteens, twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+
+        for (; i + 64 <= n; i += 64) {
+          const word* a = u + i;
+          const word* b = v + i;
+
+          csa_avx2(twos_a, ones, ones, load_avx2<X>(a, b), load_avx2<X>(a + 4, b + 4));
+          csa_avx2(twos_b, ones, ones, load_avx2<X>(a + 8, b + 8), load_avx2<X>(a + 12, b + 12));
+          csa_avx2(fours_a, twos, twos, twos_a, twos_b);
+          csa_avx2(twos_a, ones, ones, load_avx2<X>(a + 16, b + 16), load_avx2<X>(a + 20, b + 20));
+          csa_avx2(twos_b, ones, ones, load_avx2<X>(a + 24, b + 24), load_avx2<X>(a + 28, b + 28));
+          csa_avx2(fours_b, twos, twos, twos_a, twos_b);
+          csa_avx2(eights_a, fours, fours, fours_a, fours_b);
+          csa_avx2(twos_a, ones, ones, load_avx2<X>(a + 32, b + 32), load_avx2<X>(a + 36, b + 36));
+          csa_avx2(twos_b, ones, ones, load_avx2<X>(a + 40, b + 40), load_avx2<X>(a + 44, b + 44));
+          csa_avx2(fours_a, twos, twos, twos_a, twos_b);
+          csa_avx2(twos_a, ones, ones, load_avx2<X>(a + 48, b + 48), load_avx2<X>(a + 52, b + 52));
+          csa_avx2(twos_b, ones, ones, load_avx2<X>(a + 56, b + 56), load_avx2<X>(a + 60, b + 60));
+          csa_avx2(fours_b, twos, twos, twos_a, twos_b);
+          csa_avx2(eights_b, fours, fours, fours_a, fours_b);
+          csa_avx2(sixteens, eights, eights, eights_a, eights_b);
+
+          t = _mm256_add_epi64(t, popcount_avx2(sixteens));
+        }
+
+        t = _mm256_slli_epi64(t, 4);
+        t = _mm256_add_epi64(t, _mm256_slli_epi64(popcount_avx2(eights), 3));
+        t = _mm256_add_epi64(t, _mm256_slli_epi64(popcount_avx2(fours), 2));
+        t = _mm256_add_epi64(t, _mm256_slli_epi64(popcount_avx2(twos), 1));
+        t = _mm256_add_epi64(t, popcount_avx2(ones));
+      }
+
+      for (; i + 4 <= n; i += 4) {
+        t = _mm256_add_epi64(t, popcount_avx2(load_avx2<X>(u + i, v + i)));
+      }
+
+      unsigned int d = _mm256_extract_epi64(t, 0) + _mm256_extract_epi64(t, 1)
+                     + _mm256_extract_epi64(t, 2) + _mm256_extract_epi64(t, 3);
+
+      for (; i < n; i++) {
+        d += __builtin_popcountll(X ? u[i] ^ v[i] : u[i] & v[i]);
+      }
+
+      return d;
+    }
+
+    /**
+     * Compute a bounded Hamming distance using AVX2, checking the distance
+     * against the bound after every block of words. Each block is counted
+     * through the nibble lookup table and the remaining words through POPCNT.
+     */
+    __attribute__((target("avx2,popcnt")))
+    static unsigned int bounded_avx2(const word* u, const word* v, unsigned int n, unsigned int b) {
+      unsigned int i = 0;
+
+      __m256i t = _mm256_setzero_si256();
+
+      for (; i + block <= n; i += block) {
+        // The byte counts of both halves of the block fit in a byte.
+        __m256i c = _mm256_add_epi8(bytes_avx2(load_avx2<true>(u + i, v + i)), bytes_avx2(load_avx2<true>(u + i + 4, v + i + 4)));
+
+        t = _mm256_add_epi64(t, _mm256_sad_epu8(c, _mm256_setzero_si256()));
+
+        __m128i s = _mm_add_epi64(_mm256_castsi256_si128(t), _mm256_extracti128_si256(t, 1));
+
+        unsigned int d = _mm_cvtsi128_si64(s) + _mm_extract_epi64(s, 1);
+
+        if (d >= b) {
+          return d;
+        }
+      }
+
+      __m128i s = _mm_add_epi64(_mm256_castsi256_si128(t), _mm256_extracti128_si256(t, 1));
+
+      unsigned int d = _mm_cvtsi128_si64(s) + _mm_extract_epi64(s, 1);
+
+      for (; i < n; i++) {
+        d += __builtin_popcountll(u[i] ^ v[i]);
+      }
+
+      return d;
+    }
+
+    /**
+     * Count the bits set in either the XOR or the AND of two sequences of words
+     * using the AVX-512 VPOPCNTQ instruction.
+     */
+    template <bool X>
+    __attribute__((target("avx512f,avx512vpopcntdq")))
+    static unsigned int count_avx512(const word* u, const word* v, unsigned int n) {
+      unsigned int i = 0;
+
+      __m512i t = _mm512_setzero_si512();
+
+      for (; i + 8 <= n; i += 8) {
+        __m512i a = _mm512_loadu_si512(u + i);
+        __m512i b = _mm512_loadu_si512(v + i);
+
+        t = _mm512_add_epi64(t, _mm512_popcnt_epi64(X ? _mm512_xor_si512(a, b) : _mm512_and_si512(a, b)));
+      }
+
+      if (i < n) {
+        __mmask8 m = (1 << (n - i)) - 1;
+
+        __m512i a = _mm512_maskz_loadu_epi64(m, u + i);
+        __m512i b = _mm512_maskz_loadu_epi64(m, v + i);
+
+        t = _mm512_add_epi64(t, _mm512_popcnt_epi64(X ? _mm512_xor_si512(a, b) : _mm512_and_si512(a, b)));
+      }
+
+      return _mm512_reduce_add_epi64(t);
+    }
+
+    /**
+     * Compute a bounded Hamming distance using the AVX-512 VPOPCNTQ
+     * instruction, checking the distance against the bound after every block
+     * of words, which fills one register.
+     */
+    __attribute__((target("avx512f,avx512vpopcntdq")))
+    static unsigned int bounded_avx512(const word* u, const word* v, unsigned int n, unsigned int b) {
+      unsigned int d = 0;
+
+      for (unsigned int i = 0; i < n; i += block) {
+        __mmask8 m = n - i >= block ? 0xff : (1 << (n - i)) - 1;
+
+        __m512i a = _mm512_maskz_loadu_epi64(m, u + i);
+        __m512i c = _mm512_maskz_loadu_epi64(m, v + i);
+
+        d += _mm512_reduce_add_epi64(_mm512_popcnt_epi64(_mm512_xor_si512(a, c)));
+
+        if (d >= b) {
+          break;
+        }
+      }
+
+      return d;
+    }
+
+    /**
+     * Compute one-to-many Hamming distances using AVX-512. Single-word vectors
+     * are scored eight candidates at a time.
+     */
+    __attribute__((target("avx512f,avx512vpopcntdq")))
+    static void distances_avx512(const word* u, const word* vs, unsigned int n, unsigned int m, unsigned int* ds) {
+      unsigned int i = 0;
+
+      if (n == 1) {
+        __m512i q = _mm512_set1_epi64(u[0]);
+
+        for (; i + 8 <= m; i += 8) {
+          __m512i d = _mm512_popcnt_epi64(_mm512_xor_si512(q, _mm512_loadu_si512(vs + i)));
+
+          _mm256_storeu_si256((__m256i*) (ds + i), _mm512_cvtepi64_epi32(d));
+        }
+      }
+
+      for (; i < m; i++) {
+        ds[i] = count_avx512<true>(u, vs + i * n, n);
+      }
+    }
+
+    /**
+     * Gather the bits selected by a sequence of masks using the BMI2 PEXT
+     * instruction. This is only used alongside AVX-512 as a number of hosts
+     * that support AVX2 implement PEXT in slow microcode.
+     */
+    __attribute__((target("bmi2,popcnt")))
+    static word extract_bmi2(const word* v, const mask* ms, unsigned int n) {
+      word k = 0;
+
+      for (unsigned int i = 0; i < n; i++) {
+        k = append(k, _pext_u64(v[ms[i].index], ms[i].bits), __builtin_popcountll(ms[i].bits));
+      }
+
+      return k;
+    }
+#endif
+
+    /**
+     * The kernels of each instruction set, indexed by instruction set.
+     */
+    static const kernels implementations[] = {
+      {
+        count_generic<true>,
+        bounded_generic,
+        distances_each<count_generic<true>>,
+        count_generic<false>,
+        extract_generic,
+        decode_generic
+      },
+#ifdef HEMINGWAY_X86
+      {
+        count_popcnt<true>,
+        bounded_popcnt,
+        distances_each<count_popcnt<true>>,
+        count_popcnt<false>,
+        extract_generic,
+        decode_generic
+      },
+      {
+        count_avx2<true>,
+        bounded_avx2,
+        distances_each<count_avx2<true>>,
+        count_avx2<false>,
+        extract_generic,
+        decode_ssse3
+      },
+      {
+        count_avx512<true>,
+        bounded_avx512,
+        distances_avx512,
+        count_avx512<false>,
+        extract_bmi2,
+        decode_ssse3
+      },
+#endif
+    };
+
+    /**
+     * Select the fastest kernels on first use and forward to them.
+     */
+    static unsigned int resolve_distance(const word* u, const word* v, unsigned int n);
+    static unsigned int resolve_bounded(const word* u, const word* v, unsigned int n, unsigned int b);
+    static void resolve_distances(const word* u, const word* vs, unsigned int n, unsigned int m, unsigned int* ds);
+    static unsigned int resolve_dot(const word* u, const word* v, unsigned int n);
+    static word resolve_extract(const word* v, const mask* ms, unsigned int n);
+    static std::size_t resolve_decode(const std::uint8_t* in, unsigned int n, unsigned int* ids);
+
+    /**
+     * The kernels that select the fastest kernels on first use.
+     */
+    static const kernels resolver = {
+      resolve_distance,
+      resolve_bounded,
+      resolve_distances,
+      resolve_dot,
+      resolve_extract,
+      resolve_decode
+    };
+
+    /**
+     * The kernels currently in use. This is constant initialized so that
+     * kernels can be used during static initialization of other translation
+     * units, and atomic as several threads may resolve the kernels at once.
+     * The kernel tables are immutable, so relaxed ordering is enough.
+     */
+    static std::atomic<const kernels*> current(&resolver);
+
+    static unsigned int resolve_distance(const word* u, const word* v, unsigned int n) {
+      select(best());
+
+      return current.load(std::memory_order_relaxed)->distance(u, v, n);
+    }
+
+    static unsigned int resolve_bounded(const word* u, const word* v, unsigned int n, unsigned int b) {
+      select(best());
+
+      return current.load(std::memory_order_relaxed)->bounded(u, v, n, b);
+    }
+
+    static void resolve_distances(const word* u, const word* vs, unsigned int n, unsigned int m, unsigned int* ds) {
+      select(best());
+
+      current.load(std::memory_order_relaxed)->distances(u, vs, n, m, ds);
+    }
+
+    static unsigned int resolve_dot(const word* u, const word* v, unsigned int n) {
+      select(best());
+
+      return current.load(std::memory_order_relaxed)->dot(u, v, n);
+    }
+
+    static word resolve_extract(const word* v, const mask* ms, unsigned int n) {
+      select(best());
+
+      return current.load(std::memory_order_relaxed)->extract(v, ms, n);
+    }
+
+    static std::size_t resolve_decode(const std::uint8_t* in, unsigned int n, unsigned int* ids) {
+      select(best());
+
+      return current.load(std::memory_order_relaxed)->decode(in, n, ids);
+    }
+
+    /**
+     * Check if the host supports the kernels of an instruction set.
+     *
+     * @param isa The instruction set to check.
+     * @return `true` if the kernels can run on the host, otherwise `false`.
+     */
+    bool supported(isa i) {
+      if (i == generic) {
+        return true;
+      }
+
+#ifdef HEMINGWAY_X86
+      __builtin_cpu_init();
+
+      switch (i) {
+        case popcnt:
+          return __builtin_cpu_supports("popcnt");
+
+        case avx2:
+          return __builtin_cpu_supports("popcnt") && __builtin_cpu_supports("avx2");
+
+        case avx512:
+          return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq")
+              && __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("popcnt");
+
+        default:
+          return false;
+      }
+#else
+      return false;
+#endif
+    }
+
+    /**
+     * Whether the host supports the POPCNT instruction used by `count_fixed()`,
+     * detected once at startup.
+     */
+    const bool unroll = supported(popcnt);
+
+    /**
+     * Get the fastest instruction set supported by the host.
+     *
+     * @return The fastest instruction set supported by the host.
+     */
+    isa best() {
+      if (supported(avx512)) {
+        return avx512;
+      }
+
+      if (supported(avx2)) {
+        return avx2;
+      }
+
+      if (supported(popcnt)) {
+        return popcnt;
+      }
+
+      return generic;
+    }
+
+    /**
+     * Get the instruction set whose kernels are currently in use.
+     *
+     * @return The instruction set whose kernels are currently in use.
+     */
+    isa active() {
+      if (current.load(std::memory_order_relaxed) == &resolver) {
+        select(best());
+      }
+
+      return static_cast<isa>(current.load(std::memory_order_relaxed) - implementations);
+    }
+
+    /**
+     * Use the kernels of an instruction set for all subsequent calls.
+     *
+     * @param isa The instruction set to use.
+     */
+    void select(isa i) {
+      if (!supported(i)) {
+        throw std::invalid_argument("Unsupported instruction set");
+      }
+
+      current.store(&implementations[i], std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the name of an instruction set.
+     *
+     * @param isa The instruction set.
+     * @return The name of the instruction set.
+     */
+    std::string name(isa i) {
+      switch (i) {
+        case popcnt:
+          return "popcnt";
+
+        case avx2:
+          return "avx2";
+
+        case avx512:
+          return "avx512";
+
+        default:
+          return "generic";
+      }
+    }
+
+    /**
+     * Compute the Hamming distance between two sequences of words.
+     *
+     * @param u The words of the first vector.
+     * @param v The words of the second vector.
+     * @param n The number of words in each vector.
+     * @return The number of bits that differ between the two vectors.
+     */
+    unsigned int distance(const word* u, const word* v, unsigned int n) {
+      return current.load(std::memory_order_relaxed)->distance(u, v, n);
+    }
+
+    /**
+     * Compute the Hamming distance between two sequences of words, giving up
+     * once it is known to reach a bound.
+     *
+     * @param u The words of the first vector.
+     * @param v The words of the second vector.
+     * @param n The number of words in each vector.
+     * @param bound The distance at which to give up.
+     * @return The number of bits that differ between the two vectors if below the bound, otherwise a number no smaller than the bound.
+     */
+    unsigned int distance(const word* u, const word* v, unsigned int n, unsigned int b) {
+      return current.load(std::memory_order_relaxed)->bounded(u, v, n, b);
+    }
+
+    /**
+     * Compute the Hamming distances between a vector and a number of candidate
+     * vectors stored back to back.
+     *
+     * @param u The words of the query vector.
+     * @param vs The words of the candidate vectors.
+     * @param n The number of words in each vector.
+     * @param m The number of candidate vectors.
+     * @param ds The array to write the `m` distances to.
+     */
+    void distance(const word* u, const word* vs, unsigned int n, unsigned int m, unsigned int* ds) {
+      current.load(std::memory_order_relaxed)->distances(u, vs, n, m, ds);
+    }
+
+    /**
+     * Compute the dot product of two sequences of words.
+     *
+     * @param u The words of the first vector.
+     * @param v The words of the second vector.
+     * @param n The number of words in each vector.
+     * @return The number of bits that are set in both vectors.
+     */
+    unsigned int dot(const word* u, const word* v, unsigned int n) {
+      return current.load(std::memory_order_relaxed)->dot(u, v, n);
+    }
+
+    /**
+     * Count the bits set in a sequence of words.
+     *
+     * @param v The words of the vector.
+     * @param n The number of words in the vector.
+     * @return The number of bits that are set in the vector.
+     */
+    unsigned int weight(const word* v, unsigned int n) {
+      return current.load(std::memory_order_relaxed)->dot(v, v, n);
+    }
+
+    /**
+     * Gather the bits selected by a sequence of masks into a compact key.
+     *
+     * @param v The words of the vector to extract bits from.
+     * @param ms The masks selecting the bits to extract.
+     * @param n The number of masks.
+     * @return The extracted bits.
+     */
+    word extract(const word* v, const mask* ms, unsigned int n) {
+      return current.load(std::memory_order_relaxed)->extract(v, ms, n);
+    }
+
+    /**
+     * Encode a sorted sequence of ids as the differences between consecutive
+     * ids, using Stream VByte.
+     *
+     * @param ids The ids to encode, in increasing order.
+     * @param n The number of ids.
+     * @param out The array to write the at most `(n + 3) / 4 + 4 * n` encoded bytes to.
+     * @return The number of bytes written.
+     */
+    std::size_t encode(const unsigned int* ids, unsigned int n, std::uint8_t* out) {
+      std::uint8_t* d = out + (n + 3) / 4;
+
+      std::fill(out, d, 0);
+
+      unsigned int l = 0;
+
+      for (unsigned int i = 0; i < n; i++) {
+        unsigned int x = ids[i] - l;
+        unsigned int b = x < (1u << 8) ? 1 : x < (1u << 16) ? 2 : x < (1u << 24) ? 3 : 4;
+
+        out[i / 4] |= (b - 1) << (2 * (i % 4));
+
+        for (unsigned int j = 0; j < b; j++) {
+          *d++ = x >> (8 * j);
+        }
+
+        l = ids[i];
+      }
+
+      return d - out;
+    }
+
+    /**
+     * Decode a sequence of ids encoded using `kernel::encode()`.
+     *
+     * @param in The encoded bytes.
+     * @param n The number of ids.
+     * @param ids The array to write the `n` decoded ids to.
+     * @return The number of bytes read.
+     */
+    std::size_t decode(const std::uint8_t* in, unsigned int n, unsigned int* ids) {
+      return current.load(std::memory_order_relaxed)->decode(in, n, ids);
+    }
+  }
+}
@@ -0,0 +1,215 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include <sys/mman.h>
+#include <hemingway/memory.hpp>
+
+namespace lsh {
+  memory_resource::~memory_resource() {}
+
+  /**
+   * A memory resource that allocates from the heap.
+   */
+  class heap: public memory_resource {
+    public:
+      void* allocate(std::size_t n, std::size_t a) {
+        void* p = nullptr;
+
+        if (a <= alignof(std::max_align_t)) {
+          p = std::malloc(n);
+        } else if (posix_memalign(&p, a, n) != 0) {
+          p = nullptr;
+        }
+
+        if (p == nullptr && n != 0) {
+          throw std::bad_alloc();
+        }
+
+        return p;
+      }
+
+      void deallocate(void* p, std::size_t, std::size_t) {
+        std::free(p);
+      }
+  };
+
+  /**
+   * Get the resource that allocates memory from the heap, which tables use
+   * unless told otherwise.
+   *
+   * @return The heap resource.
+   */
+  memory_resource* default_resource() {
+    static heap h;
+
+    return &h;
+  }
+
+  /**
+   * Construct a new arena.
+   *
+   * @param initial The number of bytes in the first chunk, which doubles for every chunk after it.
+   * @param upstream The resource to allocate chunks from, or `nullptr` to use the heap.
+   */
+  arena::arena(std::size_t i, memory_resource* u) {
+    this->upstream_ = u == nullptr ? default_resource() : u;
+    this->initial_ = i == 0 ? 1 : i;
+    this->next_ = this->initial_;
+    this->current_ = nullptr;
+    this->left_ = 0;
+  }
+
+  /**
+   * Destroy this arena, releasing all of its memory.
+   */
+  arena::~arena() {
+    this->release();
+  }
+
+  /**
+   * The largest number of bytes in a chunk, beyond which chunks stop doubling
+   * unless a single block needs more.
+   */
+  static const std::size_t largest = std::size_t(1) << 30;
+
+  /**
+   * Allocate a block of memory from the current chunk, starting a new chunk if
+   * it has run out.
+   *
+   * @param n The number of bytes to allocate.
+   * @param alignment The alignment of the block, which is a power of two.
+   * @return The start of the block.
+   */
+  void* arena::allocate(std::size_t n, std::size_t a) {
+    std::lock_guard<std::mutex> l(this->mutex_);
+
+    std::size_t p = -reinterpret_cast<std::uintptr_t>(this->current_) & (a - 1);
+
+    if (this->current_ == nullptr || p + n > this->left_) {
+      std::size_t c = std::max(this->next_, n + a);
+
+      this->current_ = static_cast<char*>(this->upstream_->allocate(c, alignof(std::max_align_t)));
+      this->left_ = c;
+      this->chunks_.push_back({this->current_, c});
+      this->next_ = std::min(2 * this->next_, largest);
+
+      p = -reinterpret_cast<std::uintptr_t>(this->current_) & (a - 1);
+    }
+
+    char* b = this->current_ + p;
+
+    this->current_ = b + n;
+    this->left_ -= p + n;
+
+    return b;
+  }
+
+  /**
+   * Do nothing, as memory is only returned once the arena is released.
+   */
+  void arena::deallocate(void*, std::size_t, std::size_t) {}
+
+  /**
+   * Return all chunks to the upstream resource. Every block allocated from
+   * this arena becomes invalid.
+   */
+  void arena::release() {
+    std::lock_guard<std::mutex> l(this->mutex_);
+
+    for (const auto& c: this->chunks_) {
+      this->upstream_->deallocate(c.first, c.second, alignof(std::max_align_t));
+    }
+
+    this->chunks_.clear();
+    this->current_ = nullptr;
+    this->left_ = 0;
+    this->next_ = this->initial_;
+  }
+
+  /**
+   * Get the number of bytes allocated from the upstream resource.
+   *
+   * @return The number of bytes in the chunks of this arena.
+   */
+  std::size_t arena::size() const {
+    std::lock_guard<std::mutex> l(this->mutex_);
+
+    std::size_t n = 0;
+
+    for (const auto& c: this->chunks_) {
+      n += c.second;
+    }
+
+    return n;
+  }
+
+  const std::size_t huge_pages::page;
+
+  /**
+   * Construct a new huge page resource.
+   *
+   * @param upstream The resource to allocate small blocks from, or `nullptr` to use the heap.
+   */
+  huge_pages::huge_pages(memory_resource* u) {
+    this->upstream_ = u == nullptr ? default_resource() : u;
+  }
+
+  /**
+   * Allocate a block of memory. Blocks of at least one huge page are mapped
+   * with room to spare, such that the part of the mapping aligned to a huge
+   * page can be kept and the rest unmapped.
+   *
+   * @param n The number of bytes to allocate.
+   * @param alignment The alignment of the block, which is a power of two.
+   * @return The start of the block.
+   */
+  void* huge_pages::allocate(std::size_t n, std::size_t a) {
+    if (n < page || a > page) {
+      return this->upstream_->allocate(n, a);
+    }
+
+    std::size_t m = (n + page - 1) / page * page;
+
+    void* p = mmap(nullptr, m + page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (p == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+
+    char* c = static_cast<char*>(p);
+    char* b = c + (-reinterpret_cast<std::uintptr_t>(c) & (page - 1));
+
+    if (b != c) {
+      munmap(c, b - c);
+    }
+
+    if (c + page != b) {
+      munmap(b + m, c + page - b);
+    }
+
+#ifdef MADV_HUGEPAGE
+    madvise(b, m, MADV_HUGEPAGE);
+#endif
+
+    return b;
+  }
+
+  /**
+   * Deallocate a block of memory allocated from this resource.
+   *
+   * @param block The start of the block.
+   * @param n The number of bytes that were allocated.
+   * @param alignment The alignment the block was allocated with.
+   */
+  void huge_pages::deallocate(void* p, std::size_t n, std::size_t a) {
+    if (n < page || a > page) {
+      this->upstream_->deallocate(p, n, a);
+
+      return;
+    }
+
+    munmap(p, (n + page - 1) / page * page);
+  }
+}
@@ -0,0 +1,194 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <stdexcept>
+#include <hemingway/pool.hpp>
+
+namespace lsh {
+  /**
+   * Construct a new pool of worker threads.
+   *
+   * @param threads The number of worker threads, or 0 to use one per hardware thread.
+   */
+  pool::pool(unsigned int t) {
+    if (t == 0) {
+      t = std::thread::hardware_concurrency();
+    }
+
+    if (t == 0) {
+      t = 1;
+    }
+
+    this->started_ = 0;
+    this->stopping_ = false;
+    this->start_.reset(new std::condition_variable[t]);
+    this->threads_.reserve(t);
+
+    for (unsigned int i = 0; i < t; i++) {
+      this->threads_.push_back(std::thread(&pool::work, this, i, t));
+    }
+  }
+
+  /**
+   * Stop and join the worker threads of this pool.
+   */
+  pool::~pool() {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+
+      this->stopping_ = true;
+    }
+
+    for (unsigned int i = 0; i < this->threads_.size(); i++) {
+      this->start_[i].notify_one();
+    }
+
+    for (std::thread& t: this->threads_) {
+      t.join();
+    }
+  }
+
+  /**
+   * Get the number of worker threads in this pool.
+   *
+   * @return The number of worker threads in this pool.
+   */
+  unsigned int pool::size() const {
+    return this->threads_.size();
+  }
+
+  /**
+   * Run the tasks assigned to a worker until the pool stops.
+   *
+   * @param worker The index of the worker.
+   * @param workers The number of workers in this pool.
+   */
+  void pool::work(unsigned int w, unsigned int n) {
+    unsigned long b = 0;
+
+    while (true) {
+      std::list<batch>::iterator it;
+
+      {
+        std::unique_lock<std::mutex> lock(this->mutex_);
+
+        // A batch is only removed once every worker running it has finished
+        // it, so the next batch of this worker is still around. Batches are
+        // kept in the order they were started, so this is the next batch.
+        this->start_[w].wait(lock, [&] {
+          if (this->stopping_) {
+            return true;
+          }
+
+          for (it = this->batches_.begin(); it != this->batches_.end(); ++it) {
+            if (it->number > b && (it->worker == w || it->worker == n)) {
+              return true;
+            }
+          }
+
+          return false;
+        });
+
+        if (this->stopping_) {
+          return;
+        }
+
+        b = it->number;
+      }
+
+      const std::function<void(unsigned int, unsigned int)>& f = *it->task;
+
+      std::exception_ptr e;
+
+      // A batch on a single worker runs all of its tasks on that worker.
+      unsigned int d = it->worker == n ? n : 1;
+
+      for (unsigned int i = it->worker == n ? w : 0; i < it->tasks; i += d) {
+        try {
+          f(i, w);
+        } catch (...) {
+          e = std::current_exception();
+        }
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
+        if (e && !it->error) {
+          it->error = e;
+        }
+
+        it->pending--;
+      }
+
+      this->finish_.notify_all();
+    }
+  }
+
+  /**
+   * Start a batch of tasks and wait for it to finish.
+   *
+   * @param tasks The number of tasks to run.
+   * @param worker The worker to run every task on, or the number of workers to spread the tasks over all workers.
+   * @param task The function to run for each task.
+   */
+  void pool::start(unsigned int m, unsigned int w, const std::function<void(unsigned int, unsigned int)>& f) {
+    unsigned int n = this->threads_.size();
+
+    std::exception_ptr e;
+
+    {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+
+      this->batches_.push_back({&f, m, w, w == n ? n : 1, ++this->started_, nullptr});
+
+      std::list<batch>::iterator it = --this->batches_.end();
+
+      if (w == n) {
+        for (unsigned int i = 0; i < n; i++) {
+          this->start_[i].notify_one();
+        }
+      } else {
+        this->start_[w].notify_one();
+      }
+
+      this->finish_.wait(lock, [&] {
+        return it->pending == 0;
+      });
+
+      e = it->error;
+
+      this->batches_.erase(it);
+    }
+
+    if (e) {
+      std::rethrow_exception(e);
+    }
+  }
+
+  /**
+   * Run a batch of tasks on the worker threads of this pool and wait for them
+   * to finish.
+   *
+   * @param tasks The number of tasks to run.
+   * @param task The function to run for each task, given the index of the task and the index of the worker running it.
+   */
+  void pool::run(unsigned int m, const std::function<void(unsigned int, unsigned int)>& f) {
+    this->start(m, this->threads_.size(), f);
+  }
+
+  /**
+   * Run a single task on one worker thread of this pool and wait for it to
+   * finish.
+   *
+   * @param worker The index of the worker to run the task on.
+   * @param task The function to run.
+   */
+  void pool::run_on(unsigned int w, const std::function<void()>& f) {
+    if (w >= this->threads_.size()) {
+      throw std::out_of_range("Invalid worker");
+    }
+
+    this->start(1, w, [&](unsigned int, unsigned int) {
+      f();
+    });
+  }
+}
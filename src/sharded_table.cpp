@@ -0,0 +1,488 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <climits>
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <hemingway/sharded_table.hpp>
+
+namespace lsh {
+  /**
+   * Order results by increasing distance, breaking ties by id.
+   *
+   * @param a The first result.
+   * @param b The second result.
+   * @return `true` if the first result comes before the second, otherwise `false`.
+   */
+  static bool closer(const table::result& a, const table::result& b) {
+    return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+  }
+
+  /**
+   * Construct a new sharded lookup table without any shards.
+   *
+   * @param shards The number of workers to pin shards to, or 0 to use one per hardware thread.
+   */
+  sharded_table::sharded_table(unsigned int s): pool_(new pool(s)) {
+    this->shards_.reserve(this->pool_->size());
+  }
+
+  /**
+   * Construct a new sharded lookup table of classic lookup tables. Each shard
+   * samples its own bits, seeded from the seed of the configuration.
+   *
+   * @param config The configuration parameters for the shards.
+   * @param shards The number of shards, or 0 to use one per hardware thread.
+   */
+  sharded_table::sharded_table(const table::classic& c, unsigned int s): sharded_table(s) {
+    generator g(c.seed);
+
+    for (unsigned int i = 0; i < this->pool_->size(); i++) {
+      this->shards_.emplace_back(table::classic({
+        .dimensions = c.dimensions,
+        .samples = c.samples,
+        .partitions = c.partitions,
+        .probes = c.probes,
+        .seed = g(),
+        .resource = c.resource
+      }));
+    }
+  }
+
+  /**
+   * Construct a new sharded lookup table of covering lookup tables. Each shard
+   * uses its own basis, seeded from the seed of the configuration.
+   *
+   * @param config The configuration parameters for the shards.
+   * @param shards The number of shards, or 0 to use one per hardware thread.
+   */
+  sharded_table::sharded_table(const table::covering& c, unsigned int s): sharded_table(s) {
+    generator g(c.seed);
+
+    for (unsigned int i = 0; i < this->pool_->size(); i++) {
+      this->shards_.emplace_back(table::covering({
+        .dimensions = c.dimensions,
+        .radius = c.radius,
+        .seed = g(),
+        .resource = c.resource
+      }));
+    }
+  }
+
+  /**
+   * Construct a new sharded lookup table of brute-force lookup tables.
+   *
+   * @param config The configuration parameters for the shards.
+   * @param shards The number of shards, or 0 to use one per hardware thread.
+   */
+  sharded_table::sharded_table(const table::brute& c, unsigned int s): sharded_table(s) {
+    for (unsigned int i = 0; i < this->pool_->size(); i++) {
+      this->shards_.emplace_back(c);
+    }
+  }
+
+  /**
+   * Get the index of the shard that owns a vector.
+   *
+   * @param vector The vector.
+   * @return The index of the shard that owns the vector.
+   */
+  unsigned int sharded_table::shard(const vector_view& v) const {
+    return v.hash() % this->shards_.size();
+  }
+
+  /**
+   * Translate a result of a shard into a result of this table.
+   *
+   * @param result The result of the shard.
+   * @param shard The index of the shard.
+   * @return The result with the id of the vector in this table.
+   */
+  table::result sharded_table::global(const table::result& r, unsigned int s) const {
+    if (r.id == UINT_MAX) {
+      return r;
+    }
+
+    return {r.id * (unsigned int) this->shards_.size() + s, r.distance};
+  }
+
+  /**
+   * Insert a vector into a shard, on the worker of the shard.
+   *
+   * @param shard The index of the shard.
+   * @param vector The vector to insert into the shard.
+   * @return The id of the vector in this table.
+   */
+  unsigned int sharded_table::add(unsigned int s, const vector_view& v) {
+    unsigned int m = this->shards_.size();
+    unsigned int i = this->shards_[s].insert(v);
+
+    // The id in this table must fit in an unsigned int without reaching
+    // UINT_MAX, which marks results without a neighbour.
+    if (i > (UINT_MAX - 1 - s) / m) {
+      this->shards_[s].erase(i);
+
+      throw std::length_error("Table is full");
+    }
+
+    return i * m + s;
+  }
+
+  /**
+   * Get the number of shards in this lookup table.
+   *
+   * @return The number of shards in this lookup table.
+   */
+  unsigned int sharded_table::shards() const {
+    return this->shards_.size();
+  }
+
+  /**
+   * Get the number of vectors in this lookup table.
+   *
+   * @return The number of vectors in this lookup table.
+   */
+  unsigned int sharded_table::size() const {
+    unsigned int m = this->shards_.size();
+
+    std::vector<unsigned int> ns(m);
+
+    this->pool_->run(m, [&](unsigned int s, unsigned int) {
+      ns[s] = this->shards_[s].size();
+    });
+
+    unsigned int n = 0;
+
+    for (unsigned int x: ns) {
+      n += x;
+    }
+
+    return n;
+  }
+
+  /**
+   * Freeze the shards of this lookup table in parallel.
+   *
+   * @param compress Whether or not to compress the vector ids of the buckets.
+   */
+  void sharded_table::freeze(bool z) {
+    this->pool_->run(this->shards_.size(), [&](unsigned int i, unsigned int) {
+      this->shards_[i].freeze(z);
+    });
+  }
+
+  /**
+   * Insert a vector into the shard that owns it, on the worker of the shard.
+   *
+   * @param vector The vector to insert into this lookup table.
+   * @return The id of the vector, which stays the same until the vector is erased.
+   */
+  unsigned int sharded_table::insert(const vector_view& v) {
+    unsigned int s = this->shard(v);
+    unsigned int i = 0;
+
+    this->pool_->run_on(s, [&] {
+      i = this->add(s, v);
+    });
+
+    return i;
+  }
+
+  /**
+   * Insert a number of vectors into this lookup table, with each shard
+   * inserting the vectors it owns on its own worker. If any vector cannot be
+   * inserted, the vectors inserted so far are erased again before the
+   * exception is rethrown, leaving this lookup table as it was.
+   *
+   * @param vectors The vectors to insert into this lookup table.
+   * @param n The number of vectors.
+   * @return The ids of the vectors, in the order they were given.
+   */
+  std::vector<unsigned int> sharded_table::insert_batch(const vector* vs, std::size_t n) {
+    unsigned int m = this->shards_.size();
+
+    std::vector<std::vector<std::size_t>> is(m);
+
+    for (std::size_t i = 0; i < n; i++) {
+      is[this->shard(vs[i])].push_back(i);
+    }
+
+    std::vector<unsigned int> us(n);
+    std::vector<std::size_t> ds(m, 0);
+
+    try {
+      this->pool_->run(m, [&](unsigned int s, unsigned int) {
+        for (std::size_t i: is[s]) {
+          us[i] = this->add(s, vs[i]);
+          ds[s]++;
+        }
+      });
+    } catch (...) {
+      // The caller never sees the ids of the vectors that did go in, so erase
+      // them again rather than leave them stranded in the table.
+      this->pool_->run(m, [&](unsigned int s, unsigned int) {
+        for (std::size_t k = 0; k < ds[s]; k++) {
+          this->shards_[s].erase(us[is[s][k]] / m);
+        }
+      });
+
+      throw;
+    }
+
+    return us;
+  }
+
+  /**
+   * Erase a vector from the shard that owns it, on the worker of the shard.
+   *
+   * @param vector The vector to erase from this lookup table.
+   * @return `true` if the vector was found and erased, otherwise `false`.
+   */
+  bool sharded_table::erase(const vector_view& v) {
+    unsigned int s = this->shard(v);
+    bool e = false;
+
+    this->pool_->run_on(s, [&] {
+      e = this->shards_[s].erase(v);
+    });
+
+    return e;
+  }
+
+  /**
+   * Erase the vector with a given id from this lookup table, on the worker of
+   * the shard holding it.
+   *
+   * @param id The id of the vector to erase from this lookup table.
+   * @return `true` if the vector was found and erased, otherwise `false`.
+   */
+  bool sharded_table::erase(unsigned int id) {
+    unsigned int m = this->shards_.size();
+    unsigned int s = id % m;
+    bool e = false;
+
+    this->pool_->run_on(s, [&] {
+      e = this->shards_[s].erase(id / m);
+    });
+
+    return e;
+  }
+
+  /**
+   * Query every shard of this lookup table for the id of and distance to the
+   * nearest neighbour of a query vector.
+   *
+   * @param vector The query vector to look up the nearest neighbour of.
+   * @return The nearest neighbour if found, otherwise a result with an id and distance of `UINT_MAX`.
+   */
+  table::result sharded_table::query_nearest(const vector_view& v) const {
+    unsigned int m = this->shards_.size();
+
+    std::vector<table::result> rs(m);
+
+    this->pool_->run(m, [&](unsigned int s, unsigned int) {
+      rs[s] = this->global(this->shards_[s].query_nearest(v), s);
+    });
+
+    return *std::min_element(rs.begin(), rs.end(), closer);
+  }
+
+  /**
+   * Query every shard of this lookup table for the k nearest neighbours of a
+   * query vector.
+   *
+   * @param vector The query vector to look up the nearest neighbours of.
+   * @param k The number of nearest neighbours to look up.
+   * @return Up to k nearest neighbours found, ordered by increasing distance.
+   */
+  std::vector<table::result> sharded_table::query_k(const vector_view& v, unsigned int k) const {
+    unsigned int m = this->shards_.size();
+
+    std::vector<std::vector<table::result>> rs(m);
+
+    this->pool_->run(m, [&](unsigned int s, unsigned int) {
+      rs[s] = this->shards_[s].query_k(v, k);
+
+      for (table::result& r: rs[s]) {
+        r = this->global(r, s);
+      }
+    });
+
+    std::vector<table::result> ns;
+
+    for (const std::vector<table::result>& r: rs) {
+      ns.insert(ns.end(), r.begin(), r.end());
+    }
+
+    std::sort(ns.begin(), ns.end(), closer);
+
+    if (ns.size() > k) {
+      ns.resize(k);
+    }
+
+    return ns;
+  }
+
+  /**
+   * Query every shard of this lookup table for the neighbours of a query vector
+   * within a given distance.
+   *
+   * @param vector The query vector to look up the neighbours of.
+   * @param radius The distance within which to look up neighbours.
+   * @return The neighbours found within the distance, ordered by increasing distance.
+   */
+  std::vector<table::result> sharded_table::query_radius(const vector_view& v, unsigned int r) const {
+    unsigned int m = this->shards_.size();
+
+    std::vector<std::vector<table::result>> rs(m);
+
+    this->pool_->run(m, [&](unsigned int s, unsigned int) {
+      rs[s] = this->shards_[s].query_radius(v, r);
+
+      for (table::result& x: rs[s]) {
+        x = this->global(x, s);
+      }
+    });
+
+    std::vector<table::result> ns;
+
+    for (const std::vector<table::result>& x: rs) {
+      ns.insert(ns.end(), x.begin(), x.end());
+    }
+
+    std::sort(ns.begin(), ns.end(), closer);
+
+    return ns;
+  }
+
+  /**
+   * Query every shard of this lookup table for any neighbour of a query vector
+   * within a given distance.
+   *
+   * @param vector The query vector to look up a neighbour of.
+   * @param radius The distance within which to look up a neighbour.
+   * @return A neighbour found within the distance, otherwise the nearest neighbour found.
+   */
+  table::result sharded_table::query_any(const vector_view& v, unsigned int r) const {
+    unsigned int m = this->shards_.size();
+
+    std::vector<table::result> rs(m);
+
+    this->pool_->run(m, [&](unsigned int s, unsigned int) {
+      rs[s] = this->global(this->shards_[s].query_any(v, r), s);
+    });
+
+    return *std::min_element(rs.begin(), rs.end(), closer);
+  }
+
+  /**
+   * Query this lookup table for the nearest neighbours of a number of query
+   * vectors, with each shard answering every query on its own worker.
+   *
+   * @param vectors The query vectors to look up the nearest neighbours of.
+   * @param n The number of query vectors.
+   * @param results The array to write the result of each query to.
+   */
+  void sharded_table::query_batch(const vector* vs, std::size_t n, table::result* rs) const {
+    unsigned int m = this->shards_.size();
+
+    // Each shard writes its results to its own row, which are merged once all
+    // shards are done.
+    std::vector<table::result> ss(n * m);
+
+    this->pool_->run(m, [&](unsigned int s, unsigned int) {
+      const table& t = this->shards_[s];
+
+      for (std::size_t i = 0; i < n; i++) {
+        ss[s * n + i] = this->global(t.query_nearest(vs[i]), s);
+      }
+    });
+
+    for (std::size_t i = 0; i < n; i++) {
+      table::result r = ss[i];
+
+      for (unsigned int s = 1; s < m; s++) {
+        if (closer(ss[s * n + i], r)) {
+          r = ss[s * n + i];
+        }
+      }
+
+      rs[i] = r;
+    }
+  }
+
+  /**
+   * Compute a number of statistics for this lookup table, summed across its
+   * shards.
+   *
+   * @return The statistics computed for this lookup table.
+   */
+  table::statistics sharded_table::stats() const {
+    unsigned int ps = 0;
+    unsigned int bs = 0;
+    unsigned int vs = 0;
+    std::size_t ms = 0;
+    std::size_t ss = 0;
+    std::size_t mm = 0;
+    std::size_t vm = 0;
+    std::size_t im = 0;
+    std::size_t rm = 0;
+    std::uint64_t qs = 0;
+
+    std::vector<unsigned int> hs;
+    std::vector<unsigned int> ls;
+
+    table::counters c = {};
+
+    unsigned int m = this->shards_.size();
+
+    // Statistics cannot be assigned, so each shard fills its own slot.
+    std::vector<std::unique_ptr<table::statistics>> xs(m);
+
+    this->pool_->run(m, [&](unsigned int s, unsigned int) {
+      xs[s].reset(new table::statistics(this->shards_[s].stats()));
+    });
+
+    for (const std::unique_ptr<table::statistics>& x: xs) {
+      const table::statistics& s = *x;
+
+      ps += s.partitions;
+      bs += s.buckets;
+      vs += s.vectors;
+      ms += s.memory;
+      ss += s.saved;
+      mm += s.mask_memory;
+      vm += s.vector_memory;
+      im += s.id_memory;
+      rm += s.raw_id_memory;
+      qs += s.queries;
+
+      if (hs.size() < s.histogram.size()) {
+        hs.resize(s.histogram.size(), 0);
+      }
+
+      for (std::size_t i = 0; i < s.histogram.size(); i++) {
+        hs[i] += s.histogram[i];
+      }
+
+      ls.insert(ls.end(), s.largest.begin(), s.largest.end());
+
+      c += s.totals;
+    }
+
+    return {
+      .partitions = ps,
+      .buckets = bs,
+      .vectors = vs,
+      .memory = ms,
+      .saved = ss,
+      .histogram = hs,
+      .largest = ls,
+      .mask_memory = mm,
+      .vector_memory = vm,
+      .id_memory = im,
+      .raw_id_memory = rm,
+      .queries = qs,
+      .totals = c
+    };
+  }
+}
@@ -1,34 +1,252 @@
 // Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
 #include <hemingway/table.hpp>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 namespace lsh {
+  /**
+   * Scratch space that is reused by operations on the calling thread, such
+   * that computing the keys of vectors does not allocate.
+   */
+  struct scratch {
+    /**
+     * The keys of a vector in every partition.
+     */
+    std::vector<std::uint64_t> keys;
+
+    /**
+     * The projections of a vector.
+     */
+    std::vector<kernel::word> words;
+
+    /**
+     * The epoch in which each vector id was last visited by a query.
+     */
+    std::vector<unsigned int> visits;
+
+    /**
+     * The epoch of the current query.
+     */
+    unsigned int epoch;
+
+    /**
+     * The number of extra buckets probed in each partition by the current
+     * query.
+     */
+    std::vector<unsigned int> probes;
+
+    /**
+     * The first and one past the last vector id of the bucket of each query
+     * in each partition, for a group of queries.
+     */
+    std::vector<const unsigned int*> buckets;
+
+    /**
+     * The vector ids decoded from compressed buckets, one list for each
+     * bucket in flight.
+     */
+    std::vector<std::vector<unsigned int>> lists;
+  };
+
+  /**
+   * The scratch space of the calling thread.
+   */
+  static thread_local scratch local;
+
+  const bool table::counting;
+
+  /**
+   * Release the memory held by a container, keeping its allocator.
+   *
+   * @param container The container to release the memory of.
+   */
+  template <typename T>
+  static void release(T& c) {
+    T(c.get_allocator()).swap(c);
+  }
+
+  /**
+   * The number of queries that batched queries interleave at a time.
+   */
+  static const std::size_t group = 16;
+
+  /**
+   * The number of candidates ahead of the one being verified whose vectors
+   * are prefetched by batched queries.
+   */
+  static const unsigned int ahead = 8;
+
+  /**
+   * Start a new query in the scratch space of the calling thread. Candidates
+   * colliding with a query in several partitions are only verified once,
+   * which is tracked by stamping visited ids with the epoch of the query. The
+   * stamps are reset once the epoch wraps around.
+   *
+   * @param capacity The number of vector ids that may be visited.
+   * @return The epoch of the new query.
+   */
+  static unsigned int stamp(std::size_t c) {
+    std::vector<unsigned int>& vs = local.visits;
+
+    unsigned int t = ++local.epoch;
+
+    if (t == 0) {
+      std::fill(vs.begin(), vs.end(), 0);
+
+      t = local.epoch = 1;
+    }
+
+    if (vs.size() < c) {
+      vs.resize(c, 0);
+    }
+
+    return t;
+  }
+
+  /**
+   * Get the current time for timing the phases of queries.
+   *
+   * @return The number of nanoseconds since an arbitrary point in time.
+   */
+  static inline std::uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /**
+   * The fields of `table::counters`, in the order they are summed in tallies.
+   */
+  static std::uint64_t table::counters::* const counted[] = {
+    &table::counters::candidates,
+    &table::counters::duplicates,
+    &table::counters::probes,
+    &table::counters::misses,
+    &table::counters::distances,
+    &table::counters::pruned,
+    &table::counters::projection,
+    &table::counters::lookup,
+    &table::counters::verification
+  };
+
+  /**
+   * Create an empty tally.
+   */
+  table::tally::tally() {
+    this->queries = 0;
+
+    for (std::atomic<std::uint64_t>& s: this->sums) {
+      s = 0;
+    }
+  }
+
+  /**
+   * Create a copy of a tally.
+   *
+   * @param tally The tally to copy.
+   */
+  table::tally::tally(const tally& t) {
+    *this = t;
+  }
+
+  /**
+   * Replace this tally with a copy of another.
+   *
+   * @param tally The tally to copy.
+   * @return This tally.
+   */
+  table::tally& table::tally::operator=(const tally& t) {
+    this->queries = t.queries.load();
+
+    for (std::size_t i = 0; i < fields; i++) {
+      this->sums[i] = t.sums[i].load();
+    }
+
+    return *this;
+  }
+
+  /**
+   * Add the counters of a query to this tally.
+   *
+   * @param counters The counters of the query.
+   */
+  void table::tally::add(const counters& c) {
+    static_assert(sizeof(counted) / sizeof(counted[0]) == fields, "Every counter must be summed");
+
+    this->queries.fetch_add(1, std::memory_order_relaxed);
+
+    for (std::size_t i = 0; i < fields; i++) {
+      this->sums[i].fetch_add(c.*counted[i], std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Add the counters of another query or table to these counters.
+   *
+   * @param counters The counters to add.
+   * @return These counters.
+   */
+  table::counters& table::counters::operator+=(const counters& c) {
+    for (std::uint64_t counters::* f: counted) {
+      this->*f += c.*f;
+    }
+
+    return *this;
+  }
+
+  /**
+   * Get the counters summed across all queries in this tally.
+   *
+   * @return The summed counters.
+   */
+  table::counters table::tally::total() const {
+    counters c = {};
+
+    for (std::size_t i = 0; i < fields; i++) {
+      c.*counted[i] = this->sums[i];
+    }
+
+    return c;
+  }
+
   /**
    * Construct a new classic lookup table.
    *
    * @param config The configuration parameters for the lookup table.
    */
-  table::table(const classic& c) {
+  table::table(const classic& c): table(c.resource) {
     unsigned int d = c.dimensions;
     unsigned int s = c.samples;
     unsigned int p = c.partitions;
 
     this->dimensions_ = d;
-    this->masks_.reserve(p);
+    this->stride_ = (d + vector::chunk_size_ - 1) / vector::chunk_size_;
+    this->probes_ = c.probes;
+    this->offsets_.reserve(p + 1);
+    this->offsets_.push_back(0);
     this->partitions_.reserve(p);
 
-    for (unsigned int i = 0; i < p; i++) {
-      std::random_device random;
-      std::mt19937 generator(random());
-      std::uniform_int_distribution<> indices(0, d - 1);
+    unsigned int w = this->stride_;
+    unsigned int b = vector::chunk_size_;
+
+    generator g(c.seed);
 
-      std::vector<bool> c(d);
+    for (unsigned int i = 0; i < p; i++) {
+      std::vector<kernel::word> m(w);
 
       for (unsigned int i = 0; i < s; i++) {
-        c[indices(generator)] = 1;
+        unsigned int j = g.below(d);
+
+        // Compute the number of bits in the chunk holding the sampled bit.
+        unsigned int n = (j / b) * b + b > d ? d % b : b;
+
+        m[j / b] |= kernel::word(1) << (n - j % b - 1);
       }
 
-      this->masks_.push_back(vector(c));
-      this->partitions_.push_back(partition());
+      this->sample(m);
     }
   }
 
@@ -37,36 +255,38 @@ namespace lsh {
    *
    * @param config The configuration parameters for the lookup table.
    */
-  table::table(const covering& c) {
+  table::table(const covering& c): table(c.resource) {
     unsigned int d = c.dimensions;
     unsigned int r = c.radius;
     unsigned int x = r + 1;
     unsigned int n = 1 << x;
 
     this->dimensions_ = d;
-    this->masks_.reserve(n - 1);
+    this->stride_ = (d + vector::chunk_size_ - 1) / vector::chunk_size_;
     this->partitions_.reserve(n - 1);
 
-    std::vector<vector> m;
-
-    for (unsigned int i = 0; i < d; i++) {
-      m.push_back(vector::random(x));
+    for (unsigned int i = 0; i < n - 1; i++) {
+      this->partitions_.push_back(partition(partition::allocator_type(this->resource())));
     }
 
-    for (unsigned int i = 1; i < n; i++) {
-      std::vector<bool> v(x);
-      std::vector<bool> c(d);
+    unsigned int w = this->stride_;
+    unsigned int b = d % vector::chunk_size_;
 
-      for (unsigned int j = 0; j < x; j++) {
-        v[j] = (i >> (x - j - 1)) & 1;
-      }
+    generator g(c.seed);
 
-      for (unsigned int j = 0; j < d; j++) {
-        c[j] = (m[j] * v) % 2;
+    // The bits of the basis vectors for each dimension together form a random
+    // vector of x bits, which makes the basis vectors themselves random.
+    this->basis_.resize(x * w);
+
+    for (unsigned int i = 0; i < x; i++) {
+      for (unsigned int j = 0; j < w; j++) {
+        this->basis_[i * w + j] = g();
       }
 
-      this->masks_.push_back(vector(c));
-      this->partitions_.push_back(partition());
+      // Clear the unused bits of the last chunk of each basis vector.
+      if (b != 0) {
+        this->basis_[i * w + w - 1] &= (kernel::word(1) << b) - 1;
+      }
     }
   }
 
@@ -75,156 +295,2089 @@ namespace lsh {
    *
    * @param config The configuration parameters for the lookup table.
    */
-  table::table(const brute& c) {
+  table::table(const brute& c): table(c.resource) {
     unsigned int d = c.dimensions;
 
     this->dimensions_ = d;
-    this->masks_.push_back(vector(std::vector<bool>(d)));
-    this->partitions_.push_back(partition());
+    this->stride_ = (d + vector::chunk_size_ - 1) / vector::chunk_size_;
+    this->offsets_.push_back(0);
+    this->sample(std::vector<kernel::word>(this->stride_));
   }
 
   /**
-   * Get the number of vectors in this lookup table.
+   * Add a partition that samples the bits set in a mask.
    *
-   * @return The number of vectors in this lookup table.
+   * @param mask The words of the mask.
    */
-  unsigned int table::size() const {
-    return this->vectors_.size();
+  void table::sample(const std::vector<kernel::word>& m) {
+    unsigned int w = m.size();
+    unsigned int b = 0;
+
+    for (unsigned int i = 0; i < w; i++) {
+      if (m[i] != 0) {
+        this->samples_.push_back({i, m[i]});
+
+        b += __builtin_popcountll(m[i]);
+      }
+    }
+
+    this->offsets_.push_back(this->samples_.size());
+    this->widths_.push_back(b);
+    this->partitions_.push_back(partition(partition::allocator_type(this->resource())));
   }
 
   /**
-   * Insert a vector into this lookup table.
+   * Compute the key of a projection spanning a number of chunks. Single chunk
+   * projections are used as keys as is.
    *
-   * @param vector The vector to insert into this lookup table.
+   * @param projection The chunks of the projection.
+   * @param n The number of chunks.
+   * @return The key of the projection.
    */
-  void table::insert(const vector& v) {
-    if (this->dimensions_ != v.size()) {
-      throw std::invalid_argument("Invalid vector size");
+  std::uint64_t table::fold(const kernel::word* p, unsigned int n) {
+    std::uint64_t h = n == 0 ? 0 : p[0];
+
+    for (unsigned int i = 1; i < n; i++) {
+      h = ((h ^ (h >> 29)) * 0xbf58476d1ce4e5b9) ^ p[i];
     }
 
+    return h;
+  }
+
+  /**
+   * Compute the keys of a vector in every partition.
+   *
+   * @param vector The chunks of the vector to compute the keys of.
+   * @param keys The array to write the key of each partition to.
+   */
+  void table::keys(const kernel::word* v, std::uint64_t* ks) const {
     unsigned int n = this->partitions_.size();
-    unsigned int u = this->next_id_++;
 
-    this->vectors_.insert({u, v});
+    if (this->basis_.empty()) {
+      for (unsigned int i = 0; i < n; i++) {
+        unsigned int o = this->offsets_[i];
 
-    for (unsigned int i = 0; i < n; i++) {
-      vector k = this->masks_[i] & v;
-      bucket& b = this->partitions_[i][k.hash()];
+        ks[i] = kernel::extract(v, &this->samples_[o], this->offsets_[i + 1] - o);
+      }
 
-      b.push_back(u);
+      return;
+    }
+
+    unsigned int w = this->stride_;
+    unsigned int x = this->basis_.size() / w;
+
+    std::vector<kernel::word>& ps = local.words;
+
+    ps.resize((x + 1) * w);
+
+    // Project the vector onto each of the basis vectors, followed by an empty
+    // projection that the projections of the partitions are accumulated into.
+    for (unsigned int i = 0; i < x * w; i++) {
+      ps[i] = this->basis_[i] & v[i % w];
+    }
+
+    kernel::word* p = &ps[x * w];
+
+    std::fill(p, p + w, 0);
+
+    // The mask of a partition is a linear combination of the basis vectors and
+    // masking distributes over XOR, so walking the combinations in Gray code
+    // order derives each projection from the previous one by XOR'ing in the
+    // projection onto the single basis vector that changed.
+    for (unsigned int i = 1; i <= n; i++) {
+      const kernel::word* q = &ps[__builtin_ctz(i) * w];
+
+      for (unsigned int j = 0; j < w; j++) {
+        p[j] ^= q[j];
+      }
+
+      ks[i - 1] = table::fold(p, w);
     }
   }
 
   /**
-   * Erase a vector from this lookup table.
+   * Compute the bit masks of every partition of a covering table, stored back
+   * to back.
    *
-   * @param vector The vector to erase from this lookup table.
+   * @return The bit masks of every partition.
    */
-  void table::erase(const vector& v) {
-    if (this->dimensions_ != v.size()) {
-      throw std::invalid_argument("Invalid vector size");
+  std::vector<kernel::word> table::masks() const {
+    unsigned int n = this->partitions_.size();
+    unsigned int w = this->stride_;
+
+    if (this->basis_.empty()) {
+      return std::vector<kernel::word>();
     }
 
-    unsigned int n = this->partitions_.size();
-    unsigned int u = 0;
+    std::vector<kernel::word> ms((n + 1) * w);
 
-    for (const auto& it: this->vectors_) {
-      if (it.second == v) {
-        u = it.first;
-        break;
+    // Walk the combinations of basis vectors in the same Gray code order as
+    // when computing keys.
+    for (unsigned int i = 1; i <= n; i++) {
+      const kernel::word* b = &this->basis_[__builtin_ctz(i) * w];
+
+      for (unsigned int j = 0; j < w; j++) {
+        ms[i * w + j] = ms[(i - 1) * w + j] ^ b[j];
       }
     }
 
-    this->vectors_.erase(u);
+    ms.erase(ms.begin(), ms.begin() + w);
 
-    for (unsigned int i = 0; i < n; i++) {
-      partition& p = this->partitions_[i];
+    return ms;
+  }
+
+  /**
+   * Compute the key of a vector in a single partition.
+   *
+   * @param partition The index of the partition.
+   * @param vector The chunks of the vector to compute the key of.
+   * @param masks The bit masks of every partition of a covering table.
+   * @return The key of the vector in the partition.
+   */
+  std::uint64_t table::key(unsigned int i, const kernel::word* v, const kernel::word* ms) const {
+    if (this->basis_.empty()) {
+      unsigned int o = this->offsets_[i];
 
-      for (auto& it: p) {
-        bucket& b = it.second;
+      return kernel::extract(v, &this->samples_[o], this->offsets_[i + 1] - o);
+    }
 
-        for (auto j = b.begin(); j != b.end(); j++) {
-          if (*j == u) {
-            b.erase(j);
-            break;
-          }
-        }
-      }
+    unsigned int w = this->stride_;
+
+    const kernel::word* m = ms + i * w;
+
+    // This is the same as folding the projection of the vector.
+    std::uint64_t h = w == 0 ? 0 : m[0] & v[0];
+
+    for (unsigned int j = 1; j < w; j++) {
+      h = ((h ^ (h >> 29)) * 0xbf58476d1ce4e5b9) ^ (m[j] & v[j]);
     }
+
+    return h;
   }
 
   /**
-   * Query this lookup table for the nearest neighbour of a query vector.
+   * Get the number of vectors in this lookup table.
    *
-   * @param vector The query vector to look up the nearest neighbour of.
-   * @return The nearest neighbouring vector if found, otherwise a vector of size 0.
+   * @return The number of vectors in this lookup table.
    */
-  vector table::query(const vector& v) const {
-    if (this->dimensions_ != v.size()) {
-      throw std::invalid_argument("Invalid vector size");
+  unsigned int table::size() const {
+    return this->size_;
+  }
+
+  /**
+   * Find the slot of a key in a frozen partition.
+   *
+   * @param key The key to find the slot of.
+   * @param bits The number of bits used for addressing the slots.
+   * @return The first slot to probe for the key.
+   */
+  static inline std::size_t slot(std::uint64_t k, unsigned int b) {
+    return (k * 0x9e3779b97f4a7c15) >> (64 - b);
+  }
+
+  /**
+   * Get the largest difference in weight between a vector of a given weight
+   * and any vector inserted into this lookup table.
+   *
+   * @param weight The weight of the vector.
+   * @return The largest difference in weight.
+   */
+  unsigned int table::spread(unsigned int q) const {
+    unsigned int l = q > this->lightest_ ? q - this->lightest_ : 0;
+    unsigned int h = this->heaviest_ > q ? this->heaviest_ - q : 0;
+
+    return std::max(l, h);
+  }
+
+  /**
+   * Prefetch the slot of a key in a partition of this frozen lookup table,
+   * such that finding its bucket later hits the cache.
+   *
+   * @param partition The index of the partition.
+   * @param key The key whose slot to prefetch.
+   */
+  void table::prefetch(unsigned int i, std::uint64_t k) const {
+    const image& f = *this->frozen_;
+    const index& x = reinterpret_cast<const index*>(f.data + f.partitions)[i];
+
+    std::size_t j = slot(k, x.bits);
+
+    __builtin_prefetch(reinterpret_cast<const std::uint64_t*>(f.data + f.keys) + x.keys + j);
+    __builtin_prefetch(reinterpret_cast<const unsigned int*>(f.data + f.offsets) + x.offsets + j);
+  }
+
+  /**
+   * Append a number to a sequence of bytes as a varint of 7 bits per byte.
+   *
+   * @param out The bytes to write the varint to.
+   * @param n The number to write.
+   * @return One past the last byte written.
+   */
+  static std::uint8_t* put(std::uint8_t* o, unsigned int n) {
+    for (; n >= 0x80; n >>= 7) {
+      *o++ = n | 0x80;
     }
 
-    unsigned int n = this->partitions_.size();
+    *o++ = n;
 
-    // Keep track of the best candidate we've encountered.
-    const vector* best_c = nullptr;
+    return o;
+  }
 
-    // Keep track of the distance to the best candidate.
-    unsigned int best_d = UINT_MAX;
+  /**
+   * Read a varint written by `put()` from a sequence of bytes.
+   *
+   * @param in The bytes to read the varint from, which is advanced past it.
+   * @return The number read.
+   */
+  static unsigned int get(const std::uint8_t*& i) {
+    unsigned int n = 0;
 
-    for (unsigned int i = 0; i < n; i++) {
-      vector k = this->masks_[i] & v;
-      const partition& p = this->partitions_[i];
+    for (unsigned int s = 0;; s += 7) {
+      std::uint8_t b = *i++;
 
-      auto it = p.find(k.hash());
+      n |= (unsigned int) (b & 0x7f) << s;
 
-      if (it == p.end()) {
-        continue;
+      if (b < 0x80) {
+        return n;
       }
+    }
+  }
+
+  /**
+   * Find the bucket of a key in a partition.
+   *
+   * @param partition The index of the partition.
+   * @param key The key to find the bucket of.
+   * @param begin The first vector id of the bucket, if found.
+   * @param end One past the last vector id of the bucket, if found.
+   * @param buffer The buffer to decode the vector ids of a compressed bucket into, which the bucket then points into.
+   * @return `true` if the partition contains a bucket for the key, otherwise `false`.
+   */
+  bool table::find(unsigned int i, std::uint64_t k, const unsigned int*& begin, const unsigned int*& end, std::vector<unsigned int>& is) const {
+    if (this->frozen_) {
+      const image& f = *this->frozen_;
+      const index& x = reinterpret_cast<const index*>(f.data + f.partitions)[i];
 
-      const bucket& b = p.at(k.hash());
+      const std::uint64_t* ks = reinterpret_cast<const std::uint64_t*>(f.data + f.keys) + x.keys;
+      const unsigned int* os = reinterpret_cast<const unsigned int*>(f.data + f.offsets) + x.offsets;
 
-      for (unsigned int u: b) {
-        const vector& c = this->vectors_.at(u);
+      std::size_t m = (std::size_t(1) << x.bits) - 1;
 
-        unsigned int d = vector::distance(v, c);
+      for (std::size_t j = slot(k, x.bits);; j = (j + 1) & m) {
+        if (os[j] == os[j + 1]) {
+          return false;
+        }
 
-        if (d < best_d) {
-          best_c = &c;
-          best_d = d;
+        if (ks[j] != k) {
+          continue;
+        }
+
+        if (f.compressed) {
+          const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(f.data + f.ids) + x.ids + os[j];
+
+          unsigned int n = get(p);
+
+          if (is.size() < n) {
+            is.resize(n);
+          }
+
+          kernel::decode(p, n, is.data());
+
+          begin = is.data();
+          end = begin + n;
+        } else {
+          const unsigned int* ds = reinterpret_cast<const unsigned int*>(f.data + f.ids) + x.ids;
+
+          begin = ds + os[j];
+          end = ds + os[j + 1];
         }
+
+        return true;
       }
     }
 
-    return best_c ? *best_c : vector({});
+    const partition& p = this->partitions_[i];
+
+    auto it = p.find(k);
+
+    if (it == p.end()) {
+      return false;
+    }
+
+    begin = it->second.data();
+    end = begin + it->second.size();
+
+    return true;
   }
 
   /**
-   * Compute a number of statistics for this lookup table.
+   * Estimate the number of bytes used by the partitions of this lookup table.
    *
-   * @return The statistics computed for this lookup table.
+   * @return The number of bytes used by the partitions of this lookup table.
    */
-  table::statistics table::stats() const {
-    unsigned int bs = 0;
-    unsigned int vs = 0;
-    unsigned int n = this->partitions_.size();
+  std::size_t table::memory() const {
+    if (this->frozen_) {
+      const image& f = *this->frozen_;
 
-    for (unsigned int i = 0; i < n; i++) {
-      const partition& p = this->partitions_[i];
+      std::size_t n = this->partitions_.size();
+
+      if (n == 0) {
+        return 0;
+      }
 
-      bs += p.size();
+      // The sections are padded to whole pages, so count the bytes actually in
+      // use through the index of the last partition.
+      const index& x = reinterpret_cast<const index*>(f.data + f.partitions)[n - 1];
+      const unsigned int* os = reinterpret_cast<const unsigned int*>(f.data + f.offsets);
 
-      for (const auto& it: p) {
-        const bucket& b = it.second;
+      std::size_t c = std::size_t(1) << x.bits;
+
+      return n * sizeof(index)
+           + (x.keys + c) * sizeof(std::uint64_t)
+           + (x.offsets + c + 1) * sizeof(unsigned int)
+           + (x.ids + os[x.offsets + c]) * (f.compressed ? 1 : sizeof(unsigned int));
+    }
+
+    std::size_t m = 0;
+
+    for (const partition& p: this->partitions_) {
+      // Each bucket is a heap allocated node holding the key and the bucket
+      // vector along with a pointer to the next node, and the ids of each
+      // bucket live in a separate heap allocation.
+      m += sizeof(partition) + p.bucket_count() * sizeof(void*);
+      m += p.size() * (sizeof(void*) + sizeof(std::uint64_t) + sizeof(bucket));
 
-        vs += b.size();
+      for (const auto& it: p) {
+        m += it.second.capacity() * sizeof(unsigned int);
       }
     }
 
-    return {
-      .partitions = (unsigned int) this->partitions_.size(),
-      .buckets = bs,
-      .vectors = vs
-    };
+    return m;
+  }
+
+  /**
+   * Check if this lookup table has been frozen.
+   *
+   * @return `true` if this lookup table has been frozen, otherwise `false`.
+   */
+  bool table::frozen() const {
+    return this->frozen_ != nullptr;
   }
+
+  /**
+   * Freeze this lookup table, rewriting its partitions into compact arrays
+   * that are faster to query. A frozen table can no longer be modified.
+   *
+   * @param compress Whether or not to compress the vector ids of the buckets.
+   */
+  void table::freeze(bool z) {
+    if (this->frozen_) {
+      return;
+    }
+
+    std::size_t m = this->memory();
+
+    std::vector<index> xs;
+    std::vector<std::uint64_t> ks;
+    std::vector<unsigned int> os;
+    std::vector<unsigned int> is;
+    std::vector<std::uint8_t> ps;
+    std::vector<unsigned int> ss;
+
+    for (partition& p: this->partitions_) {
+      // Keep the load factor of the slots at or below one half.
+      unsigned int b = 1;
+
+      while ((std::size_t(1) << b) < 2 * p.size()) {
+        b++;
+      }
+
+      std::size_t c = std::size_t(1) << b;
+
+      std::size_t s = z ? ps.size() : is.size();
+
+      xs.push_back({b, ks.size(), os.size(), s});
+
+      std::vector<const std::pair<const std::uint64_t, bucket>*> bs(c, nullptr);
+
+      for (const auto& it: p) {
+        std::size_t j = slot(it.first, b);
+
+        while (bs[j] != nullptr) {
+          j = (j + 1) & (c - 1);
+        }
+
+        bs[j] = &it;
+      }
+
+      for (std::size_t j = 0; j < c; j++) {
+        os.push_back((z ? ps.size() : is.size()) - s);
+
+        if (bs[j] == nullptr) {
+          ks.push_back(0);
+          continue;
+        }
+
+        const bucket& k = bs[j]->second;
+
+        ks.push_back(bs[j]->first);
+
+        if (!z) {
+          is.insert(is.end(), k.begin(), k.end());
+          continue;
+        }
+
+        // Sorted ids differ by little from one to the next, which is what
+        // makes them compress.
+        ss.assign(k.begin(), k.end());
+        std::sort(ss.begin(), ss.end());
+
+        unsigned int n = ss.size();
+
+        std::size_t o = ps.size();
+
+        ps.resize(o + 5 + (n + 3) / 4 + 4 * n);
+
+        std::uint8_t* e = put(&ps[o], n);
+
+        e += kernel::encode(ss.data(), n, e);
+
+        ps.resize(e - ps.data());
+      }
+
+      os.push_back((z ? ps.size() : is.size()) - s);
+
+      // Release the memory held by the partition.
+      release(p);
+    }
+
+    const std::vector<kernel::word, allocator<kernel::word>>& vs = this->vectors_;
+
+    std::shared_ptr<image> f(new image());
+
+    f->partitions = 0;
+    f->keys = f->partitions + table::align(xs.size() * sizeof(index));
+    f->offsets = f->keys + table::align(ks.size() * sizeof(std::uint64_t));
+    f->ids = f->offsets + table::align(os.size() * sizeof(unsigned int));
+    // Decoding compressed ids may read up to 16 bytes past the last bucket.
+    f->vectors = f->ids + table::align(z ? ps.size() + 16 : is.size() * sizeof(unsigned int));
+    f->weights = f->vectors + table::align(vs.size() * sizeof(kernel::word));
+    f->size = f->weights + table::align(this->weights_.size() * sizeof(unsigned int));
+    f->capacity = this->used_.size();
+    f->compressed = z;
+
+    memory_resource* r = this->resource();
+
+    std::size_t l = f->size;
+
+    char* c = static_cast<char*>(r->allocate(l, table::page));
+
+    std::memset(c, 0, l);
+
+    f->data = c;
+    f->storage = std::shared_ptr<const void>(c, [r, l](const void* p) {
+      r->deallocate(const_cast<void*>(p), l, table::page);
+    });
+
+    std::memcpy(c + f->partitions, xs.data(), xs.size() * sizeof(index));
+    std::memcpy(c + f->keys, ks.data(), ks.size() * sizeof(std::uint64_t));
+    std::memcpy(c + f->offsets, os.data(), os.size() * sizeof(unsigned int));
+    std::memcpy(c + f->ids, is.data(), is.size() * sizeof(unsigned int));
+    std::memcpy(c + f->ids, ps.data(), ps.size());
+    std::memcpy(c + f->vectors, vs.data(), vs.size() * sizeof(kernel::word));
+    std::memcpy(c + f->weights, this->weights_.data(), this->weights_.size() * sizeof(unsigned int));
+
+    this->frozen_ = f;
+
+    // Frozen tables cannot be modified, so the vectors now live in the image
+    // and the state used for inserting and erasing vectors is no longer needed.
+    release(this->vectors_);
+    release(this->weights_);
+    release(this->used_);
+    release(this->free_);
+    release(this->positions_);
+    release(this->index_);
+
+    std::size_t n = this->memory();
+
+    this->saved_ = m > n ? m - n : 0;
+  }
+
+  /**
+   * Get the component chunks of the vectors stored in this lookup table.
+   *
+   * @return The component chunks of the vectors, indexed by vector id.
+   */
+  const kernel::word* table::arena() const {
+    if (this->frozen_) {
+      return reinterpret_cast<const kernel::word*>(this->frozen_->data + this->frozen_->vectors);
+    }
+
+    return this->vectors_.data();
+  }
+
+  /**
+   * Get the weights of the vectors stored in this lookup table.
+   *
+   * @return The number of bits set in each vector, indexed by vector id.
+   */
+  const unsigned int* table::weights() const {
+    if (this->frozen_) {
+      return reinterpret_cast<const unsigned int*>(this->frozen_->data + this->frozen_->weights);
+    }
+
+    return this->weights_.data();
+  }
+
+  /**
+   * Get the number of vector ids in the vector arena of this lookup table.
+   *
+   * @return The number of vector ids in the vector arena.
+   */
+  std::size_t table::capacity() const {
+    if (this->frozen_) {
+      return this->frozen_->capacity;
+    }
+
+    return this->used_.size();
+  }
+
+  /**
+   * Get the memory resource that this lookup table allocates from.
+   *
+   * @return The memory resource of this lookup table.
+   */
+  memory_resource* table::resource() const {
+    return this->vectors_.get_allocator().resource();
+  }
+
+  /**
+   * Round a number of bytes up to a whole number of pages.
+   *
+   * @param n The number of bytes.
+   * @return The number of bytes rounded up to a whole number of pages.
+   */
+  std::size_t table::align(std::size_t n) {
+    return (n + table::page - 1) / table::page * table::page;
+  }
+
+  /**
+   * Check whether a number of items starting at a position fit before a limit,
+   * without overflowing.
+   *
+   * @param position The position of the first item.
+   * @param count The number of items.
+   * @param size The size of each item.
+   * @param limit The position that the items must end at or before.
+   * @return `true` if the items fit, otherwise `false`.
+   */
+  static inline bool fits(std::uint64_t o, std::uint64_t n, std::uint64_t z, std::uint64_t l) {
+    return o <= l && n <= (l - o) / z;
+  }
+
+  /**
+   * Check that the sections of an image lie within it and that looking up
+   * keys in its partitions stays within its sections, such that a corrupt
+   * image cannot be read out of bounds.
+   *
+   * @param image The image to check.
+   * @param partitions The number of partitions in the image.
+   * @param stride The number of component chunks occupied by each vector.
+   * @return `true` if the image is consistent, otherwise `false`.
+   */
+  bool table::check(const image& f, std::size_t n, std::size_t w) {
+    const std::size_t ss[] = {f.partitions, f.keys, f.offsets, f.ids, f.vectors, f.weights, f.size};
+
+    for (unsigned int i = 0; i < 7; i++) {
+      if (ss[i] % table::page != 0 || (i > 0 && ss[i] < ss[i - 1])) {
+        return false;
+      }
+    }
+
+    if (f.capacity > UINT_MAX ||
+        !fits(f.partitions, n, sizeof(index), f.keys) ||
+        !fits(f.vectors, f.capacity, w * sizeof(kernel::word), f.weights) ||
+        !fits(f.weights, f.capacity, sizeof(unsigned int), f.size)) {
+      return false;
+    }
+
+    const index* xs = reinterpret_cast<const index*>(f.data + f.partitions);
+    const std::uint64_t ks = (f.offsets - f.keys) / sizeof(std::uint64_t);
+    const std::uint64_t os = (f.ids - f.offsets) / sizeof(unsigned int);
+    const std::uint64_t is = f.vectors - f.ids;
+
+    std::vector<unsigned int> ds;
+
+    for (std::size_t i = 0; i < n; i++) {
+      const index& x = xs[i];
+
+      if (x.bits == 0 || x.bits >= 64) {
+        return false;
+      }
+
+      std::uint64_t c = std::uint64_t(1) << x.bits;
+
+      if (!fits(x.keys, c, 1, ks) || !fits(x.offsets, c + 1, 1, os)) {
+        return false;
+      }
+
+      const unsigned int* o = reinterpret_cast<const unsigned int*>(f.data + f.offsets) + x.offsets;
+
+      // Lookups probe slots until they find the key or an empty slot, so
+      // every partition needs at least one empty slot.
+      bool e = false;
+
+      for (std::uint64_t j = 0; j < c; j++) {
+        if (o[j + 1] < o[j]) {
+          return false;
+        }
+
+        e = e || o[j] == o[j + 1];
+      }
+
+      if (!e) {
+        return false;
+      }
+
+      if (!f.compressed) {
+        if (!fits(x.ids, o[c], 1, is / sizeof(unsigned int))) {
+          return false;
+        }
+
+        const unsigned int* d = reinterpret_cast<const unsigned int*>(f.data + f.ids) + x.ids;
+
+        for (std::uint64_t j = o[0]; j < o[c]; j++) {
+          if (d[j] >= f.capacity) {
+            return false;
+          }
+        }
+
+        continue;
+      }
+
+      // Decoding may read up to 16 bytes past the last bucket.
+      if (!fits(x.ids, std::uint64_t(o[c]) + 16, 1, is)) {
+        return false;
+      }
+
+      for (std::uint64_t j = 0; j < c; j++) {
+        const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(f.data + f.ids) + x.ids + o[j];
+        const std::uint8_t* q = p + (o[j + 1] - o[j]);
+
+        if (p == q) {
+          continue;
+        }
+
+        // Read the number of ids without running past the end of the bucket.
+        std::uint64_t m = 0;
+
+        for (unsigned int s = 0;; s += 7) {
+          if (p == q || s > 28) {
+            return false;
+          }
+
+          std::uint8_t b = *p++;
+
+          m |= std::uint64_t(b & 0x7f) << s;
+
+          if (b < 0x80) {
+            break;
+          }
+        }
+
+        // Every control byte spans four ids of one to four bytes each.
+        std::uint64_t l = (m + 3) / 4;
+
+        if (m > UINT_MAX || l > std::uint64_t(q - p)) {
+          return false;
+        }
+
+        for (std::uint64_t k = 0; k < m; k++) {
+          l += ((p[k / 4] >> (2 * (k % 4))) & 3) + 1;
+        }
+
+        if (l > std::uint64_t(q - p)) {
+          return false;
+        }
+
+        ds.resize(m);
+
+        kernel::decode(p, m, ds.data());
+
+        for (std::uint64_t k = 0; k < m; k++) {
+          if (ds[k] >= f.capacity) {
+            return false;
+          }
+        }
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * The header of a saved lookup table, stored in the first page of the file.
+   */
+  struct header {
+    /**
+     * Identifies the file as a saved lookup table.
+     */
+    char magic[8];
+
+    /**
+     * The version of the file format.
+     */
+    std::uint32_t version;
+
+    /**
+     * A known value used for checking that the file was written in the byte
+     * order of the host.
+     */
+    std::uint32_t order;
+
+    /**
+     * The number of dimensions of vectors in the table.
+     */
+    std::uint64_t dimensions;
+
+    /**
+     * The number of vectors in the table.
+     */
+    std::uint64_t size;
+
+    /**
+     * The number of partitions in the table.
+     */
+    std::uint64_t partitions;
+
+    /**
+     * The number of word masks used for sampling bits from vectors.
+     */
+    std::uint64_t samples;
+
+    /**
+     * The number of chunks in the basis vectors of a covering table.
+     */
+    std::uint64_t basis;
+
+    /**
+     * The number of extra buckets to probe in each partition of a classic
+     * table.
+     */
+    std::uint64_t probes;
+
+    /**
+     * The smallest and largest weights of vectors inserted into the table.
+     */
+    std::uint64_t weights[2];
+
+    /**
+     * Whether or not the vector ids of the buckets in the image of the table
+     * are compressed.
+     */
+    std::uint64_t compressed;
+
+    /**
+     * The positions in the file of the word masks, their offsets per
+     * partition, the basis vectors and the image of the table.
+     */
+    std::uint64_t sections[4];
+
+    /**
+     * The number of bytes in the image of the table followed by the positions
+     * of its sections and the number of vector ids in its vector arena.
+     */
+    std::uint64_t image[8];
+  };
+
+  /**
+   * The version of the file format written by `table::save()`.
+   */
+  static const std::uint32_t version = 3;
+
+  /**
+   * Save this lookup table to a file that can later be opened using
+   * `table::open()`.
+   *
+   * @param path The path of the file to save the table to.
+   */
+  void table::save(const std::string& path) const {
+    if (!this->frozen_) {
+      table t = *this;
+
+      t.freeze();
+      t.save(path);
+
+      return;
+    }
+
+    const image& f = *this->frozen_;
+
+    // Word masks are written as pairs of words to keep padding out of the file.
+    std::vector<std::uint64_t> ms;
+
+    for (const kernel::mask& m: this->samples_) {
+      ms.push_back(m.index);
+      ms.push_back(m.bits);
+    }
+
+    header h;
+
+    std::memset(&h, 0, sizeof(header));
+    std::memcpy(h.magic, "HMNGWAY", 8);
+
+    h.version = version;
+    h.order = 0x01020304;
+    h.dimensions = this->dimensions_;
+    h.size = this->size_;
+    h.partitions = this->partitions_.size();
+    h.samples = this->samples_.size();
+    h.basis = this->basis_.size();
+    h.probes = this->probes_;
+    h.weights[0] = this->lightest_;
+    h.weights[1] = this->heaviest_;
+    h.compressed = f.compressed;
+    h.sections[0] = table::page;
+    h.sections[1] = h.sections[0] + table::align(ms.size() * sizeof(std::uint64_t));
+    h.sections[2] = h.sections[1] + table::align(this->offsets_.size() * sizeof(unsigned int));
+    h.sections[3] = h.sections[2] + table::align(this->basis_.size() * sizeof(kernel::word));
+    h.image[0] = f.size;
+    h.image[1] = f.partitions;
+    h.image[2] = f.keys;
+    h.image[3] = f.offsets;
+    h.image[4] = f.ids;
+    h.image[5] = f.vectors;
+    h.image[6] = f.weights;
+    h.image[7] = f.capacity;
+
+    std::ofstream o(path, std::ios::binary | std::ios::trunc);
+
+    if (!o) {
+      throw std::runtime_error("Could not open file");
+    }
+
+    std::vector<char> z(table::page, 0);
+
+    // Write a section followed by the padding up to the next page.
+    auto write = [&](const void* p, std::size_t n) {
+      o.write(static_cast<const char*>(p), n);
+      o.write(z.data(), table::align(n) - n);
+    };
+
+    write(&h, sizeof(header));
+    write(ms.data(), ms.size() * sizeof(std::uint64_t));
+    write(this->offsets_.data(), this->offsets_.size() * sizeof(unsigned int));
+    write(this->basis_.data(), this->basis_.size() * sizeof(kernel::word));
+    write(f.data, f.size);
+
+    if (!o.flush()) {
+      throw std::runtime_error("Could not write file");
+    }
+  }
+
+  /**
+   * Construct an empty lookup table without any partitions, allocating from a
+   * memory resource.
+   *
+   * @param resource The memory resource to allocate from, or `nullptr` to use the heap.
+   */
+  table::table(memory_resource* r): vectors_(r), weights_(r), used_(r), free_(r), positions_(r), index_(r), samples_(r), offsets_(r), widths_(r), basis_(r) {
+    this->dimensions_ = 0;
+    this->stride_ = 0;
+    this->size_ = 0;
+    this->saved_ = 0;
+    this->probes_ = 0;
+    this->lightest_ = UINT_MAX;
+    this->heaviest_ = 0;
+  }
+
+  /**
+   * Open a lookup table saved using `table::save()`.
+   *
+   * @param path The path of the file to open.
+   * @return The opened lookup table.
+   */
+  table table::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+      throw std::runtime_error("Could not open file");
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0 || std::size_t(st.st_size) < table::page) {
+      ::close(fd);
+
+      throw std::runtime_error("Invalid file");
+    }
+
+    std::size_t n = st.st_size;
+
+    void* m = mmap(nullptr, n, PROT_READ, MAP_SHARED, fd, 0);
+
+    ::close(fd);
+
+    if (m == MAP_FAILED) {
+      throw std::runtime_error("Could not map file");
+    }
+
+    std::shared_ptr<const void> storage(m, [n](const void* p) {
+      munmap(const_cast<void*>(p), n);
+    });
+
+    const char* d = static_cast<const char*>(m);
+
+    header h;
+
+    std::memcpy(&h, d, sizeof(header));
+
+    if (std::memcmp(h.magic, "HMNGWAY", 8) != 0 || h.version != version || h.order != 0x01020304) {
+      throw std::runtime_error("Invalid file");
+    }
+
+    std::uint64_t w = (h.dimensions + vector::chunk_size_ - 1) / vector::chunk_size_;
+
+    if (h.dimensions > UINT_MAX || h.partitions >= UINT_MAX || h.size > h.image[7]) {
+      throw std::runtime_error("Invalid file");
+    }
+
+    // Only classic tables probe extra buckets, as many as fit the field of
+    // the table.
+    if (h.probes > UINT_MAX || (h.basis != 0 && h.probes != 0)) {
+      throw std::runtime_error("Invalid file");
+    }
+
+    // The sections must follow one another in order, starting after the
+    // header and ending within the file, and be large enough for their counts.
+    for (unsigned int i = 0; i < 4; i++) {
+      if (h.sections[i] % table::page != 0) {
+        throw std::runtime_error("Invalid file");
+      }
+    }
+
+    if (h.sections[0] < sizeof(header) ||
+        !fits(h.sections[0], h.samples, 2 * sizeof(std::uint64_t), h.sections[1]) ||
+        !fits(h.sections[1], h.basis == 0 ? h.partitions + 1 : 0, sizeof(unsigned int), h.sections[2]) ||
+        !fits(h.sections[2], h.basis, sizeof(kernel::word), h.sections[3]) ||
+        !fits(h.sections[3], h.image[0], 1, n)) {
+      throw std::runtime_error("Invalid file");
+    }
+
+    const std::uint64_t* ms = reinterpret_cast<const std::uint64_t*>(d + h.sections[0]);
+
+    for (std::uint64_t i = 0; i < h.samples; i++) {
+      if (ms[2 * i] >= w) {
+        throw std::runtime_error("Invalid file");
+      }
+    }
+
+    if (h.basis == 0) {
+      // The samples of each partition follow those of the previous one.
+      const unsigned int* os = reinterpret_cast<const unsigned int*>(d + h.sections[1]);
+
+      for (std::uint64_t i = 0; i < h.partitions; i++) {
+        if (os[i + 1] < os[i]) {
+          throw std::runtime_error("Invalid file");
+        }
+      }
+
+      if (os[0] != 0 || os[h.partitions] != h.samples) {
+        throw std::runtime_error("Invalid file");
+      }
+    } else {
+      // A covering table has one partition per non-empty combination of its
+      // basis vectors.
+      std::uint64_t x = w == 0 ? 0 : h.basis / w;
+
+      if (x == 0 || x >= 32 || h.basis % w != 0 || h.partitions != (std::uint64_t(1) << x) - 1) {
+        throw std::runtime_error("Invalid file");
+      }
+    }
+
+    table t(nullptr);
+
+    t.dimensions_ = h.dimensions;
+    t.stride_ = w;
+    t.size_ = h.size;
+    t.probes_ = h.probes;
+    t.lightest_ = h.weights[0];
+    t.heaviest_ = h.weights[1];
+    t.partitions_.resize(h.partitions);
+
+    for (std::uint64_t i = 0; i < h.samples; i++) {
+      t.samples_.push_back({(unsigned int) ms[2 * i], ms[2 * i + 1]});
+    }
+
+    if (h.basis == 0) {
+      const unsigned int* os = reinterpret_cast<const unsigned int*>(d + h.sections[1]);
+
+      t.offsets_.assign(os, os + h.partitions + 1);
+
+      for (std::uint64_t i = 0; i < h.partitions; i++) {
+        unsigned int b = 0;
+
+        for (unsigned int o = os[i]; o < os[i + 1]; o++) {
+          b += __builtin_popcountll(ms[2 * o + 1]);
+        }
+
+        t.widths_.push_back(b);
+      }
+    }
+
+    const kernel::word* bs = reinterpret_cast<const kernel::word*>(d + h.sections[2]);
+
+    t.basis_.assign(bs, bs + h.basis);
+
+    std::shared_ptr<image> f(new image());
+
+    f->data = d + h.sections[3];
+    f->size = h.image[0];
+    f->partitions = h.image[1];
+    f->keys = h.image[2];
+    f->offsets = h.image[3];
+    f->ids = h.image[4];
+    f->vectors = h.image[5];
+    f->weights = h.image[6];
+    f->capacity = h.image[7];
+    f->compressed = h.compressed != 0;
+    f->storage = storage;
+
+    if (!table::check(*f, h.partitions, w)) {
+      throw std::runtime_error("Invalid file");
+    }
+
+    t.frozen_ = f;
+
+    return t;
+  }
+
+  /**
+   * Insert a vector into this lookup table.
+   *
+   * @param vector The vector to insert into this lookup table.
+   * @return The id of the vector, which stays the same until the vector is erased.
+   */
+  unsigned int table::insert(const vector_view& v) {
+    if (this->dimensions_ != v.size()) {
+      throw std::invalid_argument("Invalid vector size");
+    }
+
+    return this->add(v.data());
+  }
+
+  /**
+   * Insert the chunks of a vector of the size of this lookup table.
+   *
+   * @param vector The chunks of the vector to insert into this lookup table.
+   * @return The id of the vector, which stays the same until the vector is erased.
+   */
+  unsigned int table::add(const kernel::word* v) {
+    if (this->frozen_) {
+      throw std::logic_error("Table is frozen");
+    }
+
+    unsigned int n = this->partitions_.size();
+    unsigned int w = this->stride_;
+    unsigned int u;
+
+    // Reuse the slot of a previously erased vector if one is available.
+    if (this->free_.empty()) {
+      u = this->used_.size();
+
+      this->used_.push_back(true);
+      this->vectors_.insert(this->vectors_.end(), v, v + w);
+      this->weights_.push_back(0);
+    } else {
+      u = this->free_.back();
+
+      this->free_.pop_back();
+      this->used_[u] = true;
+
+      std::copy(v, v + w, this->vectors_.begin() + u * w);
+    }
+
+    this->weights_[u] = kernel::weight(v, w);
+    this->lightest_ = std::min(this->lightest_, this->weights_[u]);
+    this->heaviest_ = std::max(this->heaviest_, this->weights_[u]);
+
+    this->size_++;
+    this->positions_.resize(this->used_.size() * n);
+    this->index_.insert({table::fold(v, w), u});
+
+    std::vector<std::uint64_t>& ks = local.keys;
+
+    ks.resize(n);
+
+    this->keys(v, ks.data());
+
+    for (unsigned int i = 0; i < n; i++) {
+      bucket& b = this->partitions_[i][ks[i]];
+
+      this->positions_[std::size_t(u) * n + i] = b.size();
+
+      b.push_back(u);
+    }
+
+    return u;
+  }
+
+  /**
+   * Insert a number of vectors into this lookup table using a number of worker
+   * threads.
+   *
+   * @param vectors The vectors to insert into this lookup table.
+   * @param n The number of vectors.
+   * @param threads The number of worker threads, or 0 to use one per hardware thread.
+   * @return The ids of the vectors, in the order they were given.
+   */
+  std::vector<unsigned int> table::insert_batch(const vector* vs, std::size_t n, unsigned int t) {
+    std::vector<const kernel::word*> cs(n);
+
+    for (std::size_t i = 0; i < n; i++) {
+      if (this->dimensions_ != vs[i].size()) {
+        throw std::invalid_argument("Invalid vector size");
+      }
+
+      cs[i] = vs[i].components_.data();
+    }
+
+    return this->add_batch(cs.data(), n, t);
+  }
+
+  /**
+   * Insert the chunks of a number of vectors of the size of this lookup table
+   * using a number of worker threads.
+   *
+   * @param vectors The chunks of the vectors to insert into this lookup table.
+   * @param n The number of vectors.
+   * @param threads The number of worker threads, or 0 to use one per hardware thread.
+   * @return The ids of the vectors, in the order they were given.
+   */
+  std::vector<unsigned int> table::add_batch(const kernel::word* const* vs, std::size_t n, unsigned int t) {
+    if (this->frozen_) {
+      throw std::logic_error("Table is frozen");
+    }
+
+    unsigned int m = this->partitions_.size();
+    unsigned int w = this->stride_;
+
+    // Assign ids up front, reusing the slots of erased vectors first.
+    std::vector<unsigned int> us(n);
+
+    for (std::size_t i = 0; i < n; i++) {
+      if (this->free_.empty()) {
+        us[i] = this->used_.size();
+        this->used_.push_back(true);
+      } else {
+        us[i] = this->free_.back();
+        this->free_.pop_back();
+        this->used_[us[i]] = true;
+      }
+    }
+
+    this->vectors_.resize(this->used_.size() * w);
+    this->weights_.resize(this->used_.size());
+    this->positions_.resize(this->used_.size() * m);
+    this->size_ += n;
+
+    for (std::size_t i = 0; i < n; i++) {
+      this->index_.insert({table::fold(vs[i], w), us[i]});
+    }
+
+    std::vector<kernel::word> ms = this->masks();
+
+    pool p(t);
+
+    // Copy the vectors into the vector arena and weigh them in parallel.
+    unsigned int c = p.size();
+
+    p.run(c, [&](unsigned int j, unsigned int) {
+      for (std::size_t i = j * n / c; i < (j + 1) * n / c; i++) {
+        std::copy(vs[i], vs[i] + w, this->vectors_.begin() + us[i] * w);
+
+        this->weights_[us[i]] = kernel::weight(vs[i], w);
+      }
+    });
+
+    for (std::size_t i = 0; i < n; i++) {
+      this->lightest_ = std::min(this->lightest_, this->weights_[us[i]]);
+      this->heaviest_ = std::max(this->heaviest_, this->weights_[us[i]]);
+    }
+
+    memory_resource* r = this->resource();
+
+    // Fill each partition on its own, first counting the number of vectors
+    // going into each bucket such that buckets can be sized exactly. The keys
+    // are kept from the count for placing the vectors afterwards. Both are
+    // allocated from the resource of the table, like the rest of it.
+    p.run(m, [&](unsigned int j, unsigned int) {
+      partition& q = this->partitions_[j];
+
+      std::vector<std::uint64_t, allocator<std::uint64_t>> ks(n, r);
+      std::unordered_map<
+        std::uint64_t,
+        unsigned int,
+        std::hash<std::uint64_t>,
+        std::equal_to<std::uint64_t>,
+        allocator<std::pair<const std::uint64_t, unsigned int>>
+      > cs(0, std::hash<std::uint64_t>(), std::equal_to<std::uint64_t>(), r);
+
+      for (std::size_t i = 0; i < n; i++) {
+        ks[i] = this->key(j, vs[i], ms.data());
+
+        cs[ks[i]]++;
+      }
+
+      q.reserve(q.size() + cs.size());
+
+      for (const auto& it: cs) {
+        bucket& b = q[it.first];
+
+        b.reserve(b.size() + it.second);
+      }
+
+      for (std::size_t i = 0; i < n; i++) {
+        bucket& b = q[ks[i]];
+
+        this->positions_[std::size_t(us[i]) * m + j] = b.size();
+
+        b.push_back(us[i]);
+      }
+    });
+
+    return us;
+  }
+
+  /**
+   * Remove a vector from the buckets of every partition of this lookup table
+   * and release its id.
+   *
+   * @param id The id of the vector to remove.
+   */
+  void table::remove(unsigned int u) {
+    unsigned int n = this->partitions_.size();
+    unsigned int w = this->stride_;
+
+    const kernel::word* v = &this->vectors_[u * w];
+
+    auto r = this->index_.equal_range(table::fold(v, w));
+
+    for (auto it = r.first; it != r.second; it++) {
+      if (it->second == u) {
+        this->index_.erase(it);
+        break;
+      }
+    }
+
+    std::vector<std::uint64_t>& ks = local.keys;
+
+    ks.resize(n);
+
+    this->keys(v, ks.data());
+
+    // Move the last id of each bucket into the position of the removed id.
+    for (unsigned int i = 0; i < n; i++) {
+      partition& p = this->partitions_[i];
+
+      auto it = p.find(ks[i]);
+
+      bucket& b = it->second;
+
+      unsigned int j = this->positions_[std::size_t(u) * n + i];
+      unsigned int l = b.back();
+
+      b[j] = l;
+      this->positions_[std::size_t(l) * n + i] = j;
+
+      b.pop_back();
+
+      if (b.empty()) {
+        p.erase(it);
+      }
+    }
+
+    this->used_[u] = false;
+    this->free_.push_back(u);
+    this->size_--;
+  }
+
+  /**
+   * Erase a vector from this lookup table.
+   *
+   * @param vector The vector to erase from this lookup table.
+   * @return `true` if the vector was found and erased, otherwise `false`.
+   */
+  bool table::erase(const vector_view& v) {
+    if (this->dimensions_ != v.size()) {
+      throw std::invalid_argument("Invalid vector size");
+    }
+
+    return this->discard(v.data());
+  }
+
+  /**
+   * Erase the vector with the given chunks from this lookup table, which must
+   * be of the size of its vectors.
+   *
+   * @param vector The chunks of the vector to erase from this lookup table.
+   * @return `true` if the vector was found and erased, otherwise `false`.
+   */
+  bool table::discard(const kernel::word* v) {
+    if (this->frozen_) {
+      throw std::logic_error("Table is frozen");
+    }
+
+    unsigned int w = this->stride_;
+
+    auto r = this->index_.equal_range(table::fold(v, w));
+
+    for (auto it = r.first; it != r.second; it++) {
+      unsigned int u = it->second;
+
+      if (kernel::distance(&this->vectors_[u * w], v, w) == 0) {
+        this->remove(u);
+
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /**
+   * Erase the vector with a given id from this lookup table.
+   *
+   * @param id The id of the vector to erase from this lookup table.
+   * @return `true` if the vector was found and erased, otherwise `false`.
+   */
+  bool table::erase(unsigned int u) {
+    if (this->frozen_) {
+      throw std::logic_error("Table is frozen");
+    }
+
+    if (u >= this->used_.size() || !this->used_[u]) {
+      return false;
+    }
+
+    this->remove(u);
+
+    return true;
+  }
+
+  /**
+   * Verify the candidates of a bucket against a query vector, visiting those
+   * that are closer than a bound. Candidates already visited by the query and
+   * candidates whose weight or distance reaches the bound are skipped.
+   *
+   * @tparam N The number of chunks in vectors of this lookup table if fixed at compile time, otherwise 0.
+   * @param vector The chunks of the query vector.
+   * @param weight The weight of the query vector.
+   * @param spread The largest difference in weight between the query vector and any vector in this table.
+   * @param stamp The stamp marking the candidates visited by the query.
+   * @param begin The first vector id of the bucket.
+   * @param end One past the last vector id of the bucket.
+   * @param bound The distance from which candidates are skipped, which the visitor may lower as it goes.
+   * @param ahead The number of candidates ahead whose vectors to prefetch, or 0 to not prefetch.
+   * @param counters The counters to record the work done in.
+   * @param visit The function to call with the id of and distance to each candidate, returning `false` to stop.
+   * @return `false` if the visitor asked to stop, otherwise `true`.
+   */
+  template <unsigned int N, typename F>
+  bool table::verify(const kernel::word* v, unsigned int q, unsigned int h, unsigned int t, const unsigned int* b, const unsigned int* e, const unsigned int& bound, unsigned int p, counters& x, F f) const {
+    unsigned int w = N == 0 ? this->stride_ : N;
+
+    const kernel::word* a = this->arena();
+    const unsigned int* ws = this->weights();
+
+    std::vector<unsigned int>& vs = local.visits;
+
+    std::uint64_t clock = counting ? now() : 0;
+
+    bool go = true;
+
+    x.candidates += e - b;
+
+    for (const unsigned int* c = b; p != 0 && c != e && c != b + p; c++) {
+      __builtin_prefetch(a + *c * w);
+    }
+
+    for (; b != e && go; b++) {
+      if (p != 0 && std::size_t(e - b) > p) {
+        __builtin_prefetch(a + b[p] * w);
+      }
+
+      if (vs[*b] == t) {
+        x.duplicates++;
+        continue;
+      }
+
+      vs[*b] = t;
+
+      // The distance between two vectors is at least the difference in their
+      // weights, so candidates whose weight is too far off can be rejected
+      // without touching their components.
+      if (h >= bound) {
+        unsigned int g = ws[*b] > q ? ws[*b] - q : q - ws[*b];
+
+        if (g >= bound) {
+          x.pruned += counting;
+          continue;
+        }
+      }
+
+      x.distances += counting;
+
+      // Vectors of a few chunks are faster to compare in full than to check
+      // against the bound as they go.
+      unsigned int d = N == 0 ? kernel::distance(v, a + *b * w, w, bound) : kernel::distance<N>(v, a + *b * w);
+
+      if (d >= bound) {
+        x.pruned += counting;
+        continue;
+      }
+
+      go = f(*b, d);
+    }
+
+    if (counting) {
+      x.verification += now() - clock;
+    }
+
+    return go;
+  }
+
+  /**
+   * Visit each distinct candidate that collides with a query vector in any
+   * partition of this lookup table, until told to stop. Candidates at or
+   * beyond a bound are skipped, which lets most far away candidates be
+   * rejected without computing their full distance.
+   *
+   * @tparam N The number of chunks in vectors of this lookup table if fixed at compile time, otherwise 0.
+   * @param vector The chunks of the query vector.
+   * @param counters The counters to record the work done by the query in, if any.
+   * @param bound The distance from which candidates are skipped, which the visitor may lower as it goes.
+   * @param visit The function to call with the id of and distance to each candidate, returning `false` to stop probing partitions.
+   */
+  template <unsigned int N, typename F>
+  void table::scan(const kernel::word* v, counters* cs, const unsigned int& bound, F f) const {
+    unsigned int n = this->partitions_.size();
+    unsigned int w = N == 0 ? this->stride_ : N;
+
+    unsigned int t = stamp(this->capacity());
+
+    counters x = {};
+
+    std::uint64_t clock = counting ? now() : 0;
+
+    unsigned int q = kernel::weight(v, w);
+
+    // Candidates are only worth weighing once the bound drops to the largest
+    // difference in weight between the query and any vector in the table,
+    // which spares looking up their weights for most queries of evenly
+    // weighted vectors.
+    unsigned int h = this->spread(q);
+
+    std::vector<std::uint64_t>& ks = local.keys;
+
+    ks.resize(n);
+
+    this->keys(v, ks.data());
+
+    if (counting) {
+      x.projection = now() - clock;
+    }
+
+    bool stop = false;
+
+    std::vector<std::vector<unsigned int>>& ls = local.lists;
+
+    if (ls.empty()) {
+      ls.resize(1);
+    }
+
+    // Visit the candidates in the bucket of a key in a partition.
+    auto probe = [&](unsigned int i, std::uint64_t k) {
+      const unsigned int* b;
+      const unsigned int* e;
+
+      if (counting) {
+        x.probes++;
+        clock = now();
+      }
+
+      bool found = this->find(i, k, b, e, ls[0]);
+
+      if (counting) {
+        x.lookup += now() - clock;
+      }
+
+      if (!found) {
+        x.misses += counting;
+
+        return;
+      }
+
+      stop = !this->verify<N>(v, q, h, t, b, e, bound, 0, x, f);
+    };
+
+    for (unsigned int i = 0; i < n && !stop; i++) {
+      probe(i, ks[i]);
+    }
+
+    // Probe the buckets whose keys differ from the query keys in 1 sampled
+    // bit, then in 2 sampled bits and so on, until every partition has used
+    // up its probes. The sampled bits are packed into the low bits of exact
+    // keys, so the subsets of differing bits are enumerated as bit masks in
+    // increasing order using Gosper's hack.
+    std::vector<unsigned int>& ps = local.probes;
+
+    const unsigned int* bs = this->widths_.data();
+
+    unsigned int l = 0;
+
+    if (this->probes_ != 0) {
+      ps.assign(n, 0);
+
+      for (unsigned int i = 0; i < n; i++) {
+        // Keys of more than 64 sampled bits are mixed rather than exact, so
+        // their neighbouring buckets cannot be enumerated.
+        if (bs[i] > 64) {
+          ps[i] = this->probes_;
+        } else if (bs[i] > l) {
+          l = bs[i];
+        }
+      }
+    }
+
+    for (unsigned int d = 1; d <= l && !stop; d++) {
+      for (unsigned int i = 0; i < n && !stop; i++) {
+        unsigned int b = bs[i];
+
+        if (d > b || ps[i] == this->probes_) {
+          continue;
+        }
+
+        std::uint64_t m = d == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << d) - 1;
+
+        while (ps[i] < this->probes_ && !stop) {
+          probe(i, ks[i] ^ m);
+
+          ps[i]++;
+
+          std::uint64_t x = m & -m;
+          std::uint64_t y = m + x;
+
+          if (y == 0) {
+            break;
+          }
+
+          m = (((m ^ y) >> 2) / x) | y;
+
+          if (b < 64 && m >> b != 0) {
+            break;
+          }
+        }
+      }
+    }
+
+    if (cs != nullptr) {
+      *cs = x;
+    }
+
+    if (counting) {
+      this->totals_.add(x);
+    }
+  }
+
+  /**
+   * Search this lookup table for the nearest neighbour of a query vector.
+   *
+   * @tparam N The number of chunks in vectors of this lookup table if fixed at compile time, otherwise 0.
+   * @param vector The chunks of the query vector.
+   * @param within The distance within which to stop probing partitions as soon as a candidate is found.
+   * @param counters The counters to record the work done by the query in, if any.
+   * @return The id of and distance to the nearest neighbour.
+   */
+  template <unsigned int N>
+  table::result table::search(const kernel::word* v, unsigned int r, counters* cs) const {
+    // Keep track of the best candidate we've encountered.
+    unsigned int best_c = UINT_MAX;
+
+    // Keep track of the distance to the best candidate.
+    unsigned int best_d = UINT_MAX;
+
+    // Only candidates closer than the best candidate so far can replace it.
+    this->scan<N>(v, cs, best_d, [&](unsigned int u, unsigned int d) {
+      best_c = u;
+      best_d = d;
+
+      return best_d > r;
+    });
+
+    return {best_c, best_d};
+  }
+
+  /**
+   * Search this frozen lookup table for the nearest neighbours of a group of
+   * query vectors. Rather than following the dependent loads of one query at a
+   * time, the group goes through each stage together: The keys of every query
+   * are computed and their slots prefetched, then their buckets are found and
+   * the ids of the buckets prefetched, and finally the candidates are verified
+   * with the vectors of upcoming candidates prefetched. The cache misses of
+   * each stage thus overlap rather than stall one after another.
+   *
+   * @tparam N The number of chunks in vectors of this lookup table if fixed at compile time, otherwise 0.
+   * @param vectors The chunks of the query vectors.
+   * @param n The number of query vectors, at most `group`.
+   * @param results The array to write the id of and distance to the nearest neighbour of each query to.
+   */
+  template <unsigned int N>
+  void table::search_group(const kernel::word* const* vs, std::size_t g, result* rs) const {
+    unsigned int n = this->partitions_.size();
+    unsigned int w = N == 0 ? this->stride_ : N;
+
+    std::vector<std::uint64_t>& ks = local.keys;
+    std::vector<const unsigned int*>& bs = local.buckets;
+    std::vector<std::vector<unsigned int>>& ls = local.lists;
+
+    ks.resize(g * n);
+    bs.assign(2 * g * n, nullptr);
+
+    if (ls.size() < g * n) {
+      ls.resize(g * n);
+    }
+
+    counters xs[group] = {};
+
+    std::uint64_t clock = 0;
+
+    for (std::size_t j = 0; j < g; j++) {
+      if (counting) {
+        clock = now();
+      }
+
+      this->keys(vs[j], &ks[j * n]);
+
+      for (unsigned int i = 0; i < n; i++) {
+        this->prefetch(i, ks[j * n + i]);
+      }
+
+      if (counting) {
+        xs[j].projection = now() - clock;
+      }
+    }
+
+    for (std::size_t j = 0; j < g * n; j++) {
+      counters& x = xs[j / n];
+
+      if (counting) {
+        x.probes++;
+        clock = now();
+      }
+
+      if (this->find(j % n, ks[j], bs[2 * j], bs[2 * j + 1], ls[j])) {
+        __builtin_prefetch(bs[2 * j]);
+      } else {
+        x.misses += counting;
+      }
+
+      if (counting) {
+        x.lookup += now() - clock;
+      }
+    }
+
+    for (std::size_t j = 0; j < g; j++) {
+      const kernel::word* v = vs[j];
+
+      unsigned int t = stamp(this->capacity());
+
+      unsigned int q = kernel::weight(v, w);
+      unsigned int h = this->spread(q);
+
+      unsigned int best_c = UINT_MAX;
+      unsigned int best_d = UINT_MAX;
+
+      for (unsigned int i = 0; i < n && best_d > 0; i++) {
+        const unsigned int* b = bs[2 * (j * n + i)];
+        const unsigned int* e = bs[2 * (j * n + i) + 1];
+
+        this->verify<N>(v, q, h, t, b, e, best_d, ahead, xs[j], [&](unsigned int u, unsigned int d) {
+          best_c = u;
+          best_d = d;
+
+          return best_d > 0;
+        });
+      }
+
+      if (counting) {
+        this->totals_.add(xs[j]);
+      }
+
+      rs[j] = {best_c, best_d};
+    }
+  }
+
+  /**
+   * Query this lookup table for the nearest neighbour of a query vector.
+   *
+   * @param vector The query vector to look up the nearest neighbour of.
+   * @return The nearest neighbouring vector if found, otherwise a vector of size 0.
+   */
+  vector table::query(const vector_view& v) const {
+    counters cs;
+
+    return this->query(v, cs);
+  }
+
+  /**
+   * Query this lookup table for the nearest neighbour of a query vector,
+   * recording what the query did.
+   *
+   * @param vector The query vector to look up the nearest neighbour of.
+   * @param counters The counters to record the work done by the query in.
+   * @return The nearest neighbouring vector if found, otherwise a vector of size 0.
+   */
+  vector table::query(const vector_view& v, counters& cs) const {
+    if (this->dimensions_ != v.size()) {
+      throw std::invalid_argument("Invalid vector size");
+    }
+
+    result r = this->search<0>(v.data(), 0, &cs);
+
+    if (r.id == UINT_MAX) {
+      return vector({});
+    }
+
+    unsigned int w = this->stride_;
+
+    const kernel::word* c = this->arena() + r.id * w;
+
+    return vector(c, this->dimensions_);
+  }
+
+  /**
+   * Query this lookup table for the id of and distance to the nearest neighbour
+   * of a query vector, without copying the neighbour.
+   *
+   * @param vector The query vector to look up the nearest neighbour of.
+   * @return The nearest neighbour if found, otherwise a result with an id and distance of `UINT_MAX`.
+   */
+  table::result table::query_nearest(const vector_view& v) const {
+    if (this->dimensions_ != v.size()) {
+      throw std::invalid_argument("Invalid vector size");
+    }
+
+    return this->search<0>(v.data());
+  }
+
+  /**
+   * Order results by increasing distance, breaking ties by id.
+   */
+  static bool closer(const table::result& a, const table::result& b) {
+    return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+  }
+
+  /**
+   * Query this lookup table for the k nearest neighbours of a query vector.
+   *
+   * @param vector The query vector to look up the nearest neighbours of.
+   * @param k The number of nearest neighbours to look up.
+   * @return Up to k nearest neighbours found, ordered by increasing distance.
+   */
+  std::vector<table::result> table::query_k(const vector_view& v, unsigned int k) const {
+    if (this->dimensions_ != v.size()) {
+      throw std::invalid_argument("Invalid vector size");
+    }
+
+    return this->search_k<0>(v.data(), k);
+  }
+
+  /**
+   * Search this lookup table for the k nearest neighbours of a query vector.
+   *
+   * @tparam N The number of chunks in vectors of this lookup table if fixed at compile time, otherwise 0.
+   * @param vector The chunks of the query vector.
+   * @param k The number of nearest neighbours to look up.
+   * @return Up to k nearest neighbours found, ordered by increasing distance.
+   */
+  template <unsigned int N>
+  std::vector<table::result> table::search_k(const kernel::word* v, unsigned int k) const {
+    std::vector<result> rs;
+
+    if (k == 0) {
+      return rs;
+    }
+
+    rs.reserve(k);
+
+    // Once the heap is full, only candidates no further away than the worst of
+    // the k best candidates can replace it.
+    unsigned int l = UINT_MAX;
+
+    // Keep the k best candidates in a max-heap such that the worst of them can
+    // be replaced in logarithmic time. Once k exact matches have been found,
+    // no better candidates remain.
+    this->scan<N>(v, nullptr, l, [&](unsigned int u, unsigned int d) {
+      result r = {u, d};
+
+      if (rs.size() < k) {
+        rs.push_back(r);
+        std::push_heap(rs.begin(), rs.end(), closer);
+      } else if (closer(r, rs.front())) {
+        std::pop_heap(rs.begin(), rs.end(), closer);
+        rs.back() = r;
+        std::push_heap(rs.begin(), rs.end(), closer);
+      }
+
+      if (rs.size() == k) {
+        l = rs.front().distance + 1;
+      }
+
+      return rs.size() < k || rs.front().distance > 0;
+    });
+
+    std::sort_heap(rs.begin(), rs.end(), closer);
+
+    return rs;
+  }
+
+  /**
+   * Query this lookup table for the neighbours of a query vector within a
+   * given distance.
+   *
+   * @param vector The query vector to look up the neighbours of.
+   * @param radius The distance within which to look up neighbours.
+   * @return The neighbours found within the distance, ordered by increasing distance.
+   */
+  std::vector<table::result> table::query_radius(const vector_view& v, unsigned int r) const {
+    if (this->dimensions_ != v.size()) {
+      throw std::invalid_argument("Invalid vector size");
+    }
+
+    return this->search_radius<0>(v.data(), r);
+  }
+
+  /**
+   * Search this lookup table for the neighbours of a query vector within a
+   * given distance.
+   *
+   * @tparam N The number of chunks in vectors of this lookup table if fixed at compile time, otherwise 0.
+   * @param vector The chunks of the query vector.
+   * @param radius The distance within which to look up neighbours.
+   * @return The neighbours found within the distance, ordered by increasing distance.
+   */
+  template <unsigned int N>
+  std::vector<table::result> table::search_radius(const kernel::word* v, unsigned int r) const {
+    std::vector<result> rs;
+
+    unsigned int l = r == UINT_MAX ? UINT_MAX : r + 1;
+
+    this->scan<N>(v, nullptr, l, [&](unsigned int u, unsigned int d) {
+      rs.push_back({u, d});
+
+      return true;
+    });
+
+    std::sort(rs.begin(), rs.end(), closer);
+
+    return rs;
+  }
+
+  /**
+   * Query this lookup table for any neighbour of a query vector within a given
+   * distance, stopping as soon as one is found.
+   *
+   * @param vector The query vector to look up a neighbour of.
+   * @param radius The distance within which to look up a neighbour.
+   * @return The first neighbour found within the distance, otherwise the nearest neighbour found.
+   */
+  table::result table::query_any(const vector_view& v, unsigned int r) const {
+    if (this->dimensions_ != v.size()) {
+      throw std::invalid_argument("Invalid vector size");
+    }
+
+    return this->search<0>(v.data(), r);
+  }
+
+  /**
+   * Query this lookup table for the nearest neighbours of a number of query
+   * vectors, splitting the queries across the workers of a pool.
+   *
+   * @param vectors The query vectors to look up the nearest neighbours of.
+   * @param n The number of query vectors.
+   * @param results The array to write the result of each query to.
+   * @param pool The pool of workers to run the queries on.
+   */
+  void table::query_batch(const vector* vs, std::size_t n, result* rs, pool& p) const {
+    std::vector<const kernel::word*> cs(n);
+
+    for (std::size_t i = 0; i < n; i++) {
+      if (this->dimensions_ != vs[i].size()) {
+        throw std::invalid_argument("Invalid vector size");
+      }
+
+      cs[i] = vs[i].components_.data();
+    }
+
+    this->search_batch<0>(cs.data(), n, rs, p);
+  }
+
+  /**
+   * Search this lookup table for the nearest neighbours of a number of query
+   * vectors, splitting the queries across the workers of a pool.
+   *
+   * @tparam N The number of chunks in vectors of this lookup table if fixed at compile time, otherwise 0.
+   * @param vectors The chunks of the query vectors.
+   * @param n The number of query vectors.
+   * @param results The array to write the result of each query to.
+   * @param pool The pool of workers to run the queries on.
+   */
+  template <unsigned int N>
+  void table::search_batch(const kernel::word* const* vs, std::size_t n, result* rs, pool& p) const {
+    // Hand out the queries in small chunks to keep the workers balanced. Each
+    // worker computes keys in its own per-thread scratch space.
+    std::size_t c = 64;
+
+    // Frozen tables lay out their buckets in flat arrays whose addresses can be
+    // computed ahead of the loads, so their queries are interleaved in groups.
+    // Multi-probing decides which buckets to probe as it goes, so it is left
+    // to run one query at a time.
+    bool grouped = this->frozen_ && this->probes_ == 0;
+
+    p.run((n + c - 1) / c, [&](unsigned int j, unsigned int) {
+      std::size_t e = std::min(n, (j + 1) * c);
+
+      for (std::size_t i = j * c; i < e; i += grouped ? group : 1) {
+        if (grouped) {
+          this->search_group<N>(vs + i, std::min(group, e - i), rs + i);
+        } else {
+          rs[i] = this->search<N>(vs[i]);
+        }
+      }
+    });
+  }
+
+  /**
+   * Query this lookup table for the nearest neighbours of a number of query
+   * vectors using a number of worker threads.
+   *
+   * @param vectors The query vectors to look up the nearest neighbours of.
+   * @param n The number of query vectors.
+   * @param results The array to write the result of each query to.
+   * @param threads The number of worker threads, or 0 to use one per hardware thread.
+   */
+  void table::query_batch(const vector* vs, std::size_t n, result* rs, unsigned int t) const {
+    pool p(t);
+
+    this->query_batch(vs, n, rs, p);
+  }
+
+  /**
+   * Compute a number of statistics for this lookup table.
+   *
+   * @return The statistics computed for this lookup table.
+   */
+  table::statistics table::stats() const {
+    unsigned int bs = 0;
+    unsigned int vs = 0;
+    unsigned int n = this->partitions_.size();
+
+    std::vector<unsigned int> hs;
+    std::vector<unsigned int> ls(n, 0);
+
+    // The number of bytes of compressed vector ids, if any.
+    std::size_t zs = 0;
+
+    // Count a bucket of a partition towards the histogram of bucket sizes.
+    auto count = [&](unsigned int i, unsigned int z) {
+      unsigned int b = 31 - __builtin_clz(z);
+
+      if (hs.size() <= b) {
+        hs.resize(b + 1, 0);
+      }
+
+      hs[b]++;
+      ls[i] = std::max(ls[i], z);
+      bs++;
+      vs += z;
+    };
+
+    if (this->frozen_) {
+      const image& f = *this->frozen_;
+
+      const index* xs = reinterpret_cast<const index*>(f.data + f.partitions);
+      const unsigned int* os = reinterpret_cast<const unsigned int*>(f.data + f.offsets);
+
+      for (unsigned int i = 0; i < n; i++) {
+        const index& x = xs[i];
+
+        std::size_t c = std::size_t(1) << x.bits;
+
+        for (std::size_t j = 0; j < c; j++) {
+          unsigned int z = os[x.offsets + j + 1] - os[x.offsets + j];
+
+          if (z == 0) {
+            continue;
+          }
+
+          // The offsets of compressed buckets count bytes, so their sizes are
+          // read from the start of their ids instead.
+          if (f.compressed) {
+            const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(f.data + f.ids) + x.ids + os[x.offsets + j];
+
+            zs += z;
+            z = get(p);
+          }
+
+          count(i, z);
+        }
+      }
+    }
+
+    for (unsigned int i = 0; i < n; i++) {
+      for (const auto& it: this->partitions_[i]) {
+        count(i, it.second.size());
+      }
+    }
+
+    return {
+      .partitions = n,
+      .buckets = bs,
+      .vectors = vs,
+      .memory = this->memory(),
+      .saved = this->saved_,
+      .histogram = hs,
+      .largest = ls,
+      .mask_memory = this->samples_.size() * sizeof(kernel::mask)
+                   + (this->offsets_.size() + this->widths_.size()) * sizeof(unsigned int)
+                   + this->basis_.size() * sizeof(kernel::word),
+      .vector_memory = this->capacity() * (this->stride_ * sizeof(kernel::word) + sizeof(unsigned int)),
+      .id_memory = this->frozen_ && this->frozen_->compressed ? zs : vs * sizeof(unsigned int),
+      .raw_id_memory = vs * sizeof(unsigned int),
+      .queries = this->totals_.queries,
+      .totals = this->totals_.total()
+    };
+  }
+
+  // The searches of fixed-size tables, for vectors that are compared using
+  // the unrolled kernels, or by the kernels of any size for longer vectors.
+  static_assert(kernel::unrolled == 3, "Every unrolled size must be instantiated");
+
+  template table::result table::search<0>(const kernel::word*, unsigned int, counters*) const;
+  template table::result table::search<1>(const kernel::word*, unsigned int, counters*) const;
+  template table::result table::search<2>(const kernel::word*, unsigned int, counters*) const;
+  template table::result table::search<3>(const kernel::word*, unsigned int, counters*) const;
+  template std::vector<table::result> table::search_k<0>(const kernel::word*, unsigned int) const;
+  template std::vector<table::result> table::search_k<1>(const kernel::word*, unsigned int) const;
+  template std::vector<table::result> table::search_k<2>(const kernel::word*, unsigned int) const;
+  template std::vector<table::result> table::search_k<3>(const kernel::word*, unsigned int) const;
+  template std::vector<table::result> table::search_radius<0>(const kernel::word*, unsigned int) const;
+  template std::vector<table::result> table::search_radius<1>(const kernel::word*, unsigned int) const;
+  template std::vector<table::result> table::search_radius<2>(const kernel::word*, unsigned int) const;
+  template std::vector<table::result> table::search_radius<3>(const kernel::word*, unsigned int) const;
+  template void table::search_batch<0>(const kernel::word* const*, std::size_t, result*, pool&) const;
+  template void table::search_batch<1>(const kernel::word* const*, std::size_t, result*, pool&) const;
+  template void table::search_batch<2>(const kernel::word* const*, std::size_t, result*, pool&) const;
+  template void table::search_batch<3>(const kernel::word* const*, std::size_t, result*, pool&) const;
 }
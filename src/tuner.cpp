@@ -0,0 +1,268 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <hemingway/tuner.hpp>
+
+namespace lsh {
+  /**
+   * The largest number of partitions tried for classic configurations.
+   */
+  static const unsigned int most = 1024;
+
+  /**
+   * The largest radius tried for covering configurations. Candidate tables
+   * covering a radius r have 2^(r + 1) - 1 partitions that must all be built
+   * and measured, which beyond this radius takes more memory and time than
+   * tuning can afford.
+   */
+  static const unsigned int widest = 12;
+
+  /**
+   * Construct a new tuner.
+   *
+   * @param sample A sample of the vectors that tables will hold.
+   * @param radius The radius within which queries should find a neighbour, at most 12.
+   * @param recall The fraction of queries that should find a neighbour.
+   * @param queries The number of vectors to hold out as queries, or 0 to hold out a tenth of the sample.
+   * @param seed The seed of the candidate tables, which is drawn from a source of true randomness unless given.
+   */
+  tuner::tuner(const std::vector<vector>& s, unsigned int r, double c, unsigned int q, std::uint64_t g) {
+    std::size_t n = s.size();
+
+    if (q == 0) {
+      q = n / 10;
+    }
+
+    if (n < 2 || q == 0 || q >= n) {
+      throw std::invalid_argument("Invalid sample size");
+    }
+
+    if (c <= 0 || c > 1) {
+      throw std::invalid_argument("Invalid recall");
+    }
+
+    if (r > widest) {
+      throw std::invalid_argument("Invalid radius");
+    }
+
+    this->dimensions_ = s[0].size();
+    this->radius_ = r;
+    this->recall_ = c;
+    this->seed_ = g;
+
+    // Hold out queries spread evenly across the sample, such that the queries
+    // are not skewed by the order of the sample.
+    std::vector<vector> qs;
+
+    for (std::size_t i = 0; i < n; i++) {
+      if (qs.size() < q && i * q / n != (i + 1) * q / n) {
+        qs.push_back(s[i]);
+      } else {
+        this->vectors_.push_back(s[i]);
+      }
+    }
+
+    table b(table::brute({.dimensions = this->dimensions_}));
+
+    b.insert_batch(this->vectors_.data(), this->vectors_.size());
+
+    // Only queries that have a neighbour within the radius say anything about
+    // the recall of a configuration.
+    for (const vector& v: qs) {
+      if (b.query_any(v, r).distance <= r) {
+        this->queries_.push_back(v);
+      }
+    }
+
+    if (this->queries_.empty()) {
+      throw std::invalid_argument("No query has a neighbour within the radius");
+    }
+  }
+
+  /**
+   * Fill a table with the sample and measure it on the held-out queries.
+   *
+   * @param table The empty table to measure.
+   * @param probes The number of buckets probed per query.
+   * @return The estimated recall and cost of the table.
+   */
+  tuner::estimate tuner::measure(table& t, unsigned int p) const {
+    t.insert_batch(this->vectors_.data(), this->vectors_.size());
+    t.freeze();
+
+    unsigned int hits = 0;
+    std::uint64_t work = 0;
+
+    for (const vector& q: this->queries_) {
+      table::counters cs;
+
+      vector r = t.query(q, cs);
+
+      hits += r.size() != 0 && vector::distance(q, r) <= this->radius_;
+      work += p + cs.candidates - cs.duplicates;
+    }
+
+    double n = this->queries_.size();
+
+    return {
+      .recall = hits / n,
+      .cost = work / n
+    };
+  }
+
+  /**
+   * Measure a classic configuration on the held-out queries.
+   *
+   * @param config The configuration to measure.
+   * @return The estimated recall and cost of the configuration.
+   */
+  tuner::estimate tuner::measure(const table::classic& c) const {
+    table t(c);
+
+    return this->measure(t, c.partitions * (c.probes + 1));
+  }
+
+  /**
+   * Measure a covering configuration on the held-out queries.
+   *
+   * @param config The configuration to measure.
+   * @return The estimated recall and cost of the configuration.
+   */
+  tuner::estimate tuner::measure(const table::covering& c) const {
+    table t(c);
+
+    return this->measure(t, (2u << c.radius) - 1);
+  }
+
+  /**
+   * Find the cheapest classic configuration that meets the recall target.
+   * The configuration uses the seed of the tuner, such that tables
+   * constructed from it are the ones that were measured.
+   *
+   * @param cost The place to store the estimated cost of the configuration, if any.
+   * @return The cheapest classic configuration found.
+   */
+  table::classic tuner::classic(double* cost) const {
+    unsigned int d = this->dimensions_;
+
+    unsigned int bs = 0;
+    unsigned int bp = 0;
+    double bc = 0;
+
+    // Sampling more bits makes buckets smaller and thus queries cheaper, but
+    // lowers the chance of a neighbour sharing a bucket with the query. For
+    // each number of partitions, search for the most bits that still meet the
+    // recall target. Every partition costs at least one probe, so stop once
+    // the partitions alone cost more than the cheapest configuration so far.
+    // The number of bits is counted in an unsigned short, which caps the
+    // search for vectors of more dimensions than it can count.
+    for (unsigned int p = 1; p <= most && (bp == 0 || p < bc); p *= 2) {
+      unsigned int lo = 0;
+      unsigned int hi = std::min(d, (unsigned int) USHRT_MAX);
+      double c = 0;
+
+      while (lo < hi) {
+        unsigned int s = (lo + hi + 1) / 2;
+
+        estimate e = this->measure({
+          .dimensions = d,
+          .samples = (unsigned short) s,
+          .partitions = (unsigned short) p,
+          .seed = this->seed_
+        });
+
+        if (e.recall >= this->recall_) {
+          lo = s;
+          c = e.cost;
+        } else {
+          hi = s - 1;
+        }
+      }
+
+      if (lo != 0 && (bp == 0 || c < bc)) {
+        bs = lo;
+        bp = p;
+        bc = c;
+      }
+    }
+
+    if (bp == 0) {
+      throw std::runtime_error("Recall target cannot be met");
+    }
+
+    if (cost != nullptr) {
+      *cost = bc;
+    }
+
+    return {.dimensions = d, .samples = (unsigned short) bs, .partitions = (unsigned short) bp, .seed = this->seed_};
+  }
+
+  /**
+   * Find the cheapest covering configuration that meets the recall target.
+   * Covering the full radius always meets it, but covering a smaller radius
+   * may be cheaper and still meet it. The configuration uses the seed of the
+   * tuner, such that tables constructed from it are the ones that were
+   * measured.
+   *
+   * @param cost The place to store the estimated cost of the configuration, if any.
+   * @return The cheapest covering configuration found.
+   */
+  table::covering tuner::covering(double* cost) const {
+    unsigned int d = this->dimensions_;
+
+    unsigned int br = this->radius_;
+    double bc = 0;
+    bool found = false;
+
+    // Every partition costs at least one probe, so stop once the partitions
+    // alone cost more than the cheapest configuration so far.
+    for (unsigned int r = 0; r <= this->radius_ && (!found || (2u << r) - 1 < bc); r++) {
+      estimate e = this->measure({.dimensions = d, .radius = (unsigned short) r, .seed = this->seed_});
+
+      // Covering the full radius is the answer even if the sample happens not
+      // to meet the target, so keep its cost in that case.
+      if (!found && r == this->radius_) {
+        bc = e.cost;
+      }
+
+      if (e.recall >= this->recall_ && (!found || e.cost < bc)) {
+        br = r;
+        bc = e.cost;
+        found = true;
+      }
+    }
+
+    if (cost != nullptr) {
+      *cost = bc;
+    }
+
+    return {.dimensions = d, .radius = (unsigned short) br, .seed = this->seed_};
+  }
+
+  /**
+   * Construct an empty lookup table using the cheapest configuration of either
+   * scheme that meets the recall target. Tuners constructed with the same
+   * sample and seed construct the same table.
+   *
+   * @return The lookup table.
+   */
+  table tuner::tune() const {
+    double c;
+    double x;
+
+    table::covering v = this->covering(&c);
+
+    try {
+      table::classic k = this->classic(&x);
+
+      if (x < c) {
+        return table(k);
+      }
+    } catch (const std::runtime_error&) {
+      // No classic configuration meets the target, but covering always does.
+    }
+
+    return table(v);
+  }
+}
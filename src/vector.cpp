@@ -8,7 +8,7 @@ namespace lsh {
    * @param components The existing component chunks.
    * @param size The number of components.
    */
-  vector::vector(const std::vector<unsigned int>& cs, unsigned int s) {
+  vector::vector(const std::vector<kernel::word>& cs, unsigned int s) {
     this->size_ = s;
 
     unsigned int n = cs.size();
@@ -41,10 +41,10 @@ namespace lsh {
       // Compute the number of bits in the current chunk.
       unsigned int b = i + c > s ? s - i : c;
 
-      unsigned int e = 0;
+      kernel::word e = 0;
 
       for (unsigned int j = 0; j < b; j++) {
-        e |= cs[i + j] << (b - j - 1);
+        e |= kernel::word(cs[i + j]) << (b - j - 1);
       }
 
       this->components_.push_back(e);
@@ -55,6 +55,80 @@ namespace lsh {
     this->components_.shrink_to_fit();
   }
 
+  /**
+   * Create a new vector from components packed into words, using the layout
+   * described by `lsh::vector_view`. Unused bits of a last partial word are
+   * ignored.
+   *
+   * @param components The words holding the components.
+   * @param size The number of components.
+   */
+  vector::vector(const kernel::word* cs, unsigned int s) {
+    this->size_ = s;
+
+    unsigned int c = this->chunk_size_;
+    unsigned int n = (s + c - 1) / c;
+
+    this->components_.assign(cs, cs + n);
+
+    if (s % c != 0) {
+      this->components_[n - 1] &= (kernel::word(1) << (s % c)) - 1;
+    }
+  }
+
+  /**
+   * Create a new vector from components packed into bytes, most significant
+   * bit first, as they would arrive from the network.
+   *
+   * @param components The bytes holding the components.
+   * @param size The number of components.
+   */
+  vector::vector(const std::uint8_t* cs, unsigned int s) {
+    this->size_ = s;
+
+    unsigned int c = this->chunk_size_;
+    unsigned int n = (s + c - 1) / c;
+    unsigned int m = (s + 7) / 8;
+
+    this->components_.reserve(n);
+
+    for (unsigned int i = 0; i < n; i++) {
+      // Compute the number of bits in the current chunk.
+      unsigned int b = i * c + c > s ? s - i * c : c;
+
+      kernel::word e = 0;
+
+      for (unsigned int j = 0; j < 8 && i * 8 + j < m; j++) {
+        e |= kernel::word(cs[i * 8 + j]) << (56 - 8 * j);
+      }
+
+      // Right-align the components of a last partial chunk, dropping the
+      // padding bits of the last byte.
+      if (b < c) {
+        e >>= c - b;
+      }
+
+      this->components_.push_back(e);
+    }
+  }
+
+  /**
+   * Create a new vector holding a copy of the components of a view.
+   *
+   * @param vector The view to copy.
+   */
+  vector::vector(const vector_view& v): vector(v.data(), v.size()) {}
+
+  /**
+   * Get a view of the components of this vector. The view is invalidated when
+   * the vector is destroyed.
+   *
+   * @return A view of the components of this vector.
+   */
+  vector::operator vector_view() const {
+    return vector_view(this->components_.data(), this->size_);
+  }
+
   /**
    * Get the number of components in this vector.
    *
@@ -79,15 +153,15 @@ namespace lsh {
     }
 
     // Compute the index of the target chunk.
-    unsigned int d = i / s;
+    unsigned int d = i / c;
 
     // Compute the index of the first bit of the target chunk.
-    unsigned int j = d * s;
+    unsigned int j = d * c;
 
     // Compute the number of bits in the target chunk.
     unsigned int b = j + c > s ? s - j : c;
 
-    return (this->components_[d] >> (b - (i % s) - 1)) & 1;
+    return (this->components_[d] >> (b - (i - j) - 1)) & 1;
   }
 
   /**
@@ -142,14 +216,7 @@ namespace lsh {
       throw std::invalid_argument("Invalid vector size");
     }
 
-    unsigned int d = 0;
-    unsigned int n = this->components_.size();
-
-    for (unsigned int i = 0; i < n; i++) {
-      d += __builtin_popcount(this->components_[i] & v.components_[i]);
-    }
-
-    return d;
+    return kernel::dot(this->components_.data(), v.components_.data(), this->components_.size());
   }
 
   /**
@@ -158,20 +225,8 @@ namespace lsh {
    * @param vector The other vector.
    * @return The bitwise AND of this and another vector.
    */
-  vector vector::operator&(const vector& v) const {
-    if (this->size() != v.size()) {
-      throw std::invalid_argument("Invalid vector size");
-    }
-
-    unsigned int n = this->components_.size();
-
-    std::vector<unsigned int> c(n);
-
-    for (unsigned int i = 0; i < n; i++) {
-      c[i] = this->components_[i] & v.components_[i];
-    }
-
-    return vector(c, this->size_);
+  vector vector::operator&(const vector_view& v) const {
+    return vector_view(*this) & v;
   }
 
   /**
@@ -180,17 +235,7 @@ namespace lsh {
    * @return The hash of this vector.
    */
   unsigned int vector::hash() const {
-    unsigned int n = this->components_.size();
-
-    unsigned long h = 0;
-
-    std::hash<unsigned int> hasher;
-
-    for (unsigned int i = 0; i < n; i++) {
-      h ^= hasher(this->components_[i]) + (h << 6) + (h >> 2);
-    }
-
-    return h ^ (h >> (sizeof(unsigned int) * 8));
+    return vector_view(*this).hash();
   }
 
   /**
@@ -200,21 +245,19 @@ namespace lsh {
    * @param v The second vector.
    * @return The distance between the two vectors.
    */
-  unsigned int vector::distance(const vector& u, const vector& v) {
+  unsigned int vector::distance(const vector_view& u, const vector_view& v) {
     if (u.size() != v.size()) {
       throw std::invalid_argument("Invalid vector size");
     }
 
-    unsigned int d = 0;
-    unsigned int n = u.components_.size();
-
-    for (unsigned int i = 0; i < n; i++) {
-      d += __builtin_popcount(u.components_[i] ^ v.components_[i]);
-    }
-
-    return d;
+    return kernel::distance(u.data(), v.data(), u.chunks());
   }
 
+  /**
+   * The generator of the calling thread, seeded randomly on first use.
+   */
+  static thread_local generator local;
+
   /**
    * Construct a random vector of a given dimensionality.
    *
@@ -222,16 +265,46 @@ namespace lsh {
    * @return The randomly generated vector.
    */
   vector vector::random(unsigned int d) {
-    std::random_device random;
-    std::mt19937 generator(random());
-    std::uniform_int_distribution<> components(0, 1);
+    return vector::random(d, local);
+  }
+
+  /**
+   * Construct a random vector of a given dimensionality, drawing its
+   * components a word at a time from a generator.
+   *
+   * @param dimensions The number of dimensions in the vector.
+   * @param generator The generator to draw the components from.
+   * @return The randomly generated vector.
+   */
+  vector vector::random(unsigned int d, generator& g) {
+    unsigned int c = vector::chunk_size_;
+
+    std::vector<kernel::word> ws((d + c - 1) / c);
+
+    for (kernel::word& w: ws) {
+      w = g();
+    }
+
+    return vector(ws.data(), d);
+  }
+
+  /**
+   * Construct a number of random vectors of a given dimensionality.
+   *
+   * @param dimensions The number of dimensions in the vectors.
+   * @param n The number of vectors.
+   * @param generator The generator to draw the components from.
+   * @return The randomly generated vectors.
+   */
+  std::vector<vector> vector::random_batch(unsigned int d, std::size_t n, generator& g) {
+    std::vector<vector> vs;
 
-    std::vector<bool> c(d);
+    vs.reserve(n);
 
-    for (unsigned int i = 0; i < d; i++) {
-      c[i] = components(generator);
+    for (std::size_t i = 0; i < n; i++) {
+      vs.push_back(vector::random(d, g));
     }
 
-    return vector(c);
+    return vs;
   }
 }
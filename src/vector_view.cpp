@@ -0,0 +1,114 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <functional>
+#include <hemingway/vector_view.hpp>
+#include <hemingway/vector.hpp>
+
+namespace lsh {
+  /**
+   * Create a new view of packed components. The words must outlive the view.
+   *
+   * @param components The words holding the components.
+   * @param size The number of components.
+   */
+  vector_view::vector_view(const kernel::word* cs, unsigned int s) {
+    this->components_ = cs;
+    this->size_ = s;
+  }
+
+  /**
+   * Get the number of components in the viewed vector.
+   *
+   * @return The number of components in the viewed vector.
+   */
+  unsigned int vector_view::size() const {
+    return this->size_;
+  }
+
+  /**
+   * Get the number of words holding the components of the viewed vector.
+   *
+   * @return The number of words holding the components.
+   */
+  unsigned int vector_view::chunks() const {
+    unsigned int c = sizeof(kernel::word) * 8;
+
+    return (this->size_ + c - 1) / c;
+  }
+
+  /**
+   * Get the words holding the components of the viewed vector.
+   *
+   * @return The words holding the components.
+   */
+  const kernel::word* vector_view::data() const {
+    return this->components_;
+  }
+
+  /**
+   * Get the component at the specified index of the viewed vector.
+   *
+   * @param index The index of the component to get.
+   * @return The component at the index.
+   */
+  bool vector_view::get(unsigned int i) const {
+    unsigned int s = this->size_;
+    unsigned int c = sizeof(kernel::word) * 8;
+
+    if (i >= s) {
+      throw std::out_of_range("Invalid index");
+    }
+
+    // Compute the index of the target chunk.
+    unsigned int d = i / c;
+
+    // Compute the index of the first bit of the target chunk.
+    unsigned int j = d * c;
+
+    // Compute the number of bits in the target chunk.
+    unsigned int b = j + c > s ? s - j : c;
+
+    return (this->components_[d] >> (b - (i - j) - 1)) & 1;
+  }
+
+  /**
+   * Compute the bitwise AND of the viewed vector and another vector.
+   *
+   * @param vector The other vector.
+   * @return The bitwise AND of the two vectors.
+   */
+  vector vector_view::operator&(const vector_view& v) const {
+    if (this->size() != v.size()) {
+      throw std::invalid_argument("Invalid vector size");
+    }
+
+    unsigned int n = this->chunks();
+
+    std::vector<kernel::word> c(n);
+
+    for (unsigned int i = 0; i < n; i++) {
+      c[i] = this->components_[i] & v.components_[i];
+    }
+
+    return vector(c.data(), this->size_);
+  }
+
+  /**
+   * Compute the hash of the viewed vector. The hash equals that of an
+   * `lsh::vector` with the same components.
+   *
+   * @return The hash of the viewed vector.
+   */
+  unsigned int vector_view::hash() const {
+    unsigned int n = this->chunks();
+
+    unsigned long h = 0;
+
+    std::hash<kernel::word> hasher;
+
+    for (unsigned int i = 0; i < n; i++) {
+      h ^= hasher(this->components_[i]) + (h << 6) + (h >> 2);
+    }
+
+    return h ^ (h >> (sizeof(unsigned int) * 8));
+  }
+}
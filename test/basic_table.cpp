@@ -0,0 +1,145 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <cstdio>
+#include <test.hpp>
+#include <hemingway/basic_vector.hpp>
+#include <hemingway/basic_table.hpp>
+
+TEST_CASE("Fixed-size tables find the vectors inserted into them") {
+  lsh::basic_table<128> c({.radius = 2});
+  lsh::basic_table<128> s({.samples = 8, .partitions = 4});
+  lsh::basic_table<128> b((lsh::basic_table<128>::brute()));
+
+  std::vector<lsh::basic_vector<128>> vs;
+
+  for (unsigned int i = 0; i < 50; i++) {
+    vs.push_back(lsh::basic_vector<128>::random());
+  }
+
+  for (lsh::basic_table<128>* t: {&c, &s, &b}) {
+    for (unsigned int i = 0; i < 50; i++) {
+      REQUIRE(t->insert(vs[i]) == i);
+    }
+
+    REQUIRE(t->size() == 50);
+
+    for (unsigned int i = 0; i < 50; i++) {
+      REQUIRE(t->query_nearest(vs[i]).id == i);
+      REQUIRE(t->query_nearest(vs[i]).distance == 0);
+    }
+
+    REQUIRE(t->erase(vs[0]));
+    REQUIRE(t->erase(1));
+    REQUIRE(t->size() == 48);
+    REQUIRE(t->query_k(vs[2], 1)[0].id == 2);
+  }
+}
+
+TEST_CASE("Fixed-size covering tables find all vectors within their radius") {
+  lsh::basic_table<64> t({.radius = 2});
+
+  lsh::kernel::word w = 0x0123456789abcdef;
+  lsh::kernel::word n = w ^ 0x0000000100000001;
+
+  t.insert(lsh::basic_vector<64>(&w));
+  t.freeze();
+
+  REQUIRE(t.frozen());
+  REQUIRE(t.query_radius(lsh::basic_vector<64>(&n), 2).size() == 1);
+  REQUIRE(t.query_any(lsh::basic_vector<64>(&n), 2).distance == 2);
+}
+
+TEST_CASE("Fixed-size tables insert and query batches of vectors") {
+  lsh::basic_table<192> t({.samples = 8, .partitions = 8, .seed = 2});
+
+  std::vector<lsh::basic_vector<192>> vs;
+
+  for (unsigned int i = 0; i < 200; i++) {
+    vs.push_back(lsh::basic_vector<192>::random());
+  }
+
+  std::vector<unsigned int> us = t.insert_batch(vs.data(), vs.size(), 2);
+
+  REQUIRE(t.size() == 200);
+
+  t.freeze();
+
+  std::vector<lsh::table::result> rs(vs.size());
+
+  t.query_batch(vs.data(), vs.size(), rs.data(), 2);
+
+  for (unsigned int i = 0; i < 200; i++) {
+    REQUIRE(rs[i].id == us[i]);
+    REQUIRE(rs[i].distance == 0);
+  }
+}
+
+TEST_CASE("Fixed-size tables open tables of their size") {
+  lsh::basic_table<128> t({.radius = 2});
+
+  lsh::basic_vector<128> v = lsh::basic_vector<128>::random();
+
+  t.insert(v);
+  t.save("table.hmw");
+
+  lsh::basic_table<128> o = lsh::basic_table<128>::open("table.hmw");
+
+  REQUIRE(o.frozen());
+  REQUIRE(o.query_nearest(v).distance == 0);
+  REQUIRE_THROWS_AS(lsh::basic_table<64>::open("table.hmw"), std::invalid_argument);
+
+  std::remove("table.hmw");
+}
+
+TEST_CASE("Fixed-size tables find the same neighbours as tables of any size") {
+  lsh::basic_table<192> f({.samples = 12, .partitions = 6, .probes = 3, .seed = 4});
+  lsh::table t({.dimensions = 192, .samples = 12, .partitions = 6, .probes = 3, .seed = 4});
+
+  std::vector<lsh::basic_vector<192>> vs;
+
+  for (unsigned int i = 0; i < 300; i++) {
+    vs.push_back(lsh::basic_vector<192>::random());
+
+    f.insert(vs[i]);
+    t.insert(vs[i]);
+  }
+
+  for (unsigned int i = 0; i < 50; i++) {
+    lsh::basic_vector<192> q = lsh::basic_vector<192>::random();
+
+    REQUIRE(f.query_nearest(q).distance == t.query_nearest(q).distance);
+    REQUIRE(f.query_k(q, 5).size() == t.query_k(q, 5).size());
+    REQUIRE(f.query_radius(q, 90).size() == t.query_radius(q, 90).size());
+  }
+}
+
+TEST_CASE("Fixed-size tables of vectors too long for the unrolled kernels find their vectors") {
+  lsh::basic_table<256> f({.samples = 12, .partitions = 6, .seed = 3});
+  lsh::table t({.dimensions = 256, .samples = 12, .partitions = 6, .seed = 3});
+
+  std::vector<lsh::basic_vector<256>> vs;
+
+  for (unsigned int i = 0; i < 100; i++) {
+    vs.push_back(lsh::basic_vector<256>::random());
+
+    REQUIRE(f.insert(vs[i]) == i);
+    t.insert(vs[i]);
+  }
+
+  std::vector<lsh::table::result> rs(100);
+
+  f.query_batch(vs.data(), 100, rs.data());
+
+  for (unsigned int i = 0; i < 100; i++) {
+    REQUIRE(f.query_nearest(vs[i]).id == i);
+    REQUIRE(f.query_k(vs[i], 3)[0].id == i);
+    REQUIRE(f.query_radius(vs[i], 0).size() == 1);
+    REQUIRE(rs[i].id == i);
+  }
+
+  for (unsigned int i = 0; i < 20; i++) {
+    lsh::basic_vector<256> q = lsh::basic_vector<256>::random();
+
+    REQUIRE(f.query_nearest(q).distance == t.query_nearest(q).distance);
+    REQUIRE(f.query_radius(q, 120).size() == t.query_radius(q, 120).size());
+  }
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <test.hpp>
+#include <hemingway/vector.hpp>
+#include <hemingway/basic_vector.hpp>
+
+lsh::kernel::word ws[] = {0x8000000000000001, 0x0000000000000003};
+
+lsh::basic_vector<128> v(ws);
+
+TEST_CASE("#size returns the number of components in a fixed-size vector") {
+  static_assert(lsh::basic_vector<128>::size() == 128, "size is known at compile time");
+
+  REQUIRE(v.size() == 128);
+  REQUIRE(sizeof(lsh::basic_vector<128>) == 16);
+}
+
+TEST_CASE("#get returns the component at a specified index of a fixed-size vector") {
+  for (unsigned int i = 0; i < 128; i++) {
+    bool c = i == 0 || i == 63 || i == 126 || i == 127;
+
+    REQUIRE(v.get(i) == c);
+  }
+
+  REQUIRE_THROWS_AS(v.get(128), std::out_of_range);
+}
+
+TEST_CASE("Fixed-size vectors agree with vectors of the same components") {
+  std::vector<bool> c(128);
+
+  c[0] = c[63] = c[126] = c[127] = 1;
+
+  lsh::vector u(c);
+
+  REQUIRE(lsh::basic_vector<128>(c) == v);
+  REQUIRE(lsh::basic_vector<128>(lsh::vector_view(u)) == v);
+  REQUIRE(lsh::vector(lsh::vector_view(v)) == u);
+  REQUIRE(v.hash() == u.hash());
+  REQUIRE(v.to_string() == u.to_string());
+
+  REQUIRE_THROWS_AS(lsh::basic_vector<64>(c).data(), std::invalid_argument);
+}
+
+TEST_CASE("#* computes the dot product of two fixed-size vectors") {
+  lsh::kernel::word us[] = {0x8000000000000000, 0x0000000000000007};
+
+  REQUIRE(v * lsh::basic_vector<128>(us) == 3);
+}
+
+TEST_CASE("#& computes the bitwise AND of two fixed-size vectors") {
+  lsh::kernel::word us[] = {0x8000000000000000, 0x0000000000000007};
+  lsh::kernel::word rs[] = {0x8000000000000000, 0x0000000000000003};
+
+  REQUIRE((v & lsh::basic_vector<128>(us)) == lsh::basic_vector<128>(rs));
+}
+
+TEST_CASE(".distance computes the distance between two fixed-size vectors") {
+  for (unsigned int i = 0; i < 100; i++) {
+    lsh::basic_vector<256> a = lsh::basic_vector<256>::random();
+    lsh::basic_vector<256> b = lsh::basic_vector<256>::random();
+
+    unsigned int d = lsh::vector::distance(a, b);
+
+    REQUIRE(lsh::basic_vector<256>::distance(a, b) == d);
+    REQUIRE(lsh::basic_vector<256>::distance(a, a) == 0);
+  }
+}
+
+TEST_CASE(".random generates the same fixed-size vectors from the same seed") {
+  lsh::generator g(7);
+  lsh::generator h(7);
+
+  REQUIRE(lsh::basic_vector<128>::random(g) == lsh::basic_vector<128>::random(h));
+  REQUIRE(lsh::basic_vector<128>::random(g) != lsh::basic_vector<128>::random(g));
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <atomic>
+#include <thread>
+#include <test.hpp>
+#include <hemingway/vector.hpp>
+#include <hemingway/concurrent_table.hpp>
+
+TEST_CASE("Concurrent tables can be queried while vectors are inserted and erased") {
+  lsh::concurrent_table t(lsh::table({.dimensions = 64, .radius = 2}), 4);
+
+  std::vector<lsh::vector> ks;
+  std::vector<lsh::vector> vs;
+
+  for (unsigned int i = 0; i < 100; i++) {
+    ks.push_back(lsh::vector::random(64));
+    vs.push_back(lsh::vector::random(64));
+  }
+
+  for (unsigned int i = 0; i < 100; i++) {
+    t.insert(ks[i]);
+  }
+
+  std::atomic<bool> done(false);
+  std::atomic<unsigned int> misses(0);
+
+  std::vector<std::thread> readers;
+
+  for (unsigned int r = 0; r < 4; r++) {
+    readers.push_back(std::thread([&]() {
+      while (!done) {
+        for (unsigned int i = 0; i < 100; i++) {
+          if (t.query_nearest(ks[i]).id != i) {
+            misses++;
+          }
+        }
+      }
+    }));
+  }
+
+  for (unsigned int n = 0; n < 10; n++) {
+    for (unsigned int i = 0; i < 100; i++) {
+      t.insert(vs[i]);
+    }
+
+    for (unsigned int i = 0; i < 100; i++) {
+      t.erase(vs[i]);
+    }
+  }
+
+  done = true;
+
+  for (std::thread& r: readers) {
+    r.join();
+  }
+
+  REQUIRE(misses == 0);
+  REQUIRE(t.size() == 100);
+  REQUIRE(t.query(ks[0]) == ks[0]);
+}
+
+TEST_CASE("Concurrent tables insert batches of vectors") {
+  lsh::concurrent_table t(lsh::table({.dimensions = 64, .samples = 8, .partitions = 4}));
+
+  std::vector<lsh::vector> vs;
+
+  for (unsigned int i = 0; i < 100; i++) {
+    vs.push_back(lsh::vector::random(64));
+  }
+
+  std::vector<unsigned int> is = t.insert_batch(vs.data(), vs.size(), 2);
+
+  REQUIRE(t.size() == 100);
+
+  for (unsigned int i = 0; i < 100; i++) {
+    REQUIRE(t.query_nearest(vs[i]).id == is[i]);
+    REQUIRE(t.query_k(vs[i], 1)[0].distance == 0);
+  }
+
+  REQUIRE(t.erase(is[0]));
+  REQUIRE(t.stats().vectors == 99 * 4);
+}
+
+TEST_CASE("Concurrent tables let writers in while readers keep querying") {
+  lsh::concurrent_table t(lsh::table({.dimensions = 64, .radius = 2}), 2);
+
+  lsh::vector v = lsh::vector::random(64);
+
+  t.insert(v);
+
+  std::atomic<bool> done(false);
+
+  std::vector<std::thread> readers;
+
+  for (unsigned int r = 0; r < 4; r++) {
+    readers.push_back(std::thread([&]() {
+      while (!done) {
+        t.query_nearest(v);
+      }
+    }));
+  }
+
+  for (unsigned int i = 0; i < 1000; i++) {
+    t.insert(lsh::vector::random(64));
+  }
+
+  done = true;
+
+  for (std::thread& r: readers) {
+    r.join();
+  }
+
+  REQUIRE(t.size() == 1001);
+}
@@ -0,0 +1,33 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <test.hpp>
+#include <hemingway/generator.hpp>
+
+TEST_CASE("Generators produce the same words for the same seed") {
+  lsh::generator g(1);
+  lsh::generator h(1);
+  lsh::generator k(2);
+
+  REQUIRE(g() == 0xb3f2af6d0fc710c5);
+  REQUIRE(g() == 0x853b559647364cea);
+
+  REQUIRE(h() == 0xb3f2af6d0fc710c5);
+  REQUIRE(k() != 0xb3f2af6d0fc710c5);
+}
+
+TEST_CASE("#below generates numbers below a bound") {
+  lsh::generator g(3);
+
+  std::vector<unsigned int> cs(5);
+
+  for (unsigned int i = 0; i < 1000; i++) {
+    unsigned int n = g.below(5);
+
+    REQUIRE(n < 5);
+
+    cs[n]++;
+  }
+
+  for (unsigned int c: cs) {
+    REQUIRE(c > 0);
+  }
+}
@@ -0,0 +1,182 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <vector>
+#include <climits>
+#include <test.hpp>
+#include <hemingway/kernel.hpp>
+
+using namespace lsh;
+
+std::vector<kernel::word> words(unsigned int n, kernel::word seed) {
+  std::vector<kernel::word> w(n);
+
+  for (unsigned int i = 0; i < n; i++) {
+    seed = seed * 6364136223846793005 + 1442695040888963407;
+    w[i] = seed ^ (seed >> 29);
+  }
+
+  return w;
+}
+
+const kernel::isa isas[] = {kernel::generic, kernel::popcnt, kernel::avx2, kernel::avx512};
+
+TEST_CASE(".best returns a supported instruction set") {
+  REQUIRE(kernel::supported(kernel::generic));
+  REQUIRE(kernel::supported(kernel::best()));
+}
+
+TEST_CASE(".select changes the active instruction set") {
+  kernel::select(kernel::generic);
+
+  REQUIRE(kernel::active() == kernel::generic);
+
+  kernel::select(kernel::best());
+
+  REQUIRE(kernel::active() == kernel::best());
+}
+
+TEST_CASE(".distance computes the same distances with every instruction set") {
+  for (unsigned int n = 1; n <= 130; n++) {
+    std::vector<kernel::word> u = words(n, n);
+    std::vector<kernel::word> v = words(n, n + 1000);
+
+    kernel::select(kernel::generic);
+
+    unsigned int d = kernel::distance(u.data(), v.data(), n);
+    unsigned int p = kernel::dot(u.data(), v.data(), n);
+
+    for (kernel::isa i: isas) {
+      if (!kernel::supported(i)) {
+        continue;
+      }
+
+      kernel::select(i);
+
+      REQUIRE(kernel::distance(u.data(), v.data(), n) == d);
+      REQUIRE(kernel::dot(u.data(), v.data(), n) == p);
+      REQUIRE(kernel::distance(u.data(), u.data(), n) == 0);
+    }
+  }
+
+  kernel::select(kernel::best());
+}
+
+TEST_CASE(".distance computes one-to-many distances") {
+  for (unsigned int n = 1; n <= 5; n++) {
+    unsigned int m = 19;
+
+    std::vector<kernel::word> u = words(n, n);
+    std::vector<kernel::word> vs = words(n * m, n + 1000);
+
+    for (kernel::isa i: isas) {
+      if (!kernel::supported(i)) {
+        continue;
+      }
+
+      kernel::select(i);
+
+      std::vector<unsigned int> ds(m);
+
+      kernel::distance(u.data(), vs.data(), n, m, ds.data());
+
+      for (unsigned int j = 0; j < m; j++) {
+        REQUIRE(ds[j] == kernel::distance(u.data(), &vs[j * n], n));
+      }
+    }
+  }
+
+  kernel::select(kernel::best());
+}
+
+TEST_CASE(".distance gives up once a distance reaches a bound") {
+  for (kernel::isa i: isas) {
+    if (!kernel::supported(i)) {
+      continue;
+    }
+
+    kernel::select(i);
+
+    for (unsigned int n = 1; n <= 64; n++) {
+      std::vector<kernel::word> u = words(n, n);
+      std::vector<kernel::word> v = words(n, n + 1000);
+
+      unsigned int d = kernel::distance(u.data(), v.data(), n);
+
+      REQUIRE(kernel::distance(u.data(), v.data(), n, d + 1) == d);
+      REQUIRE(kernel::distance(u.data(), v.data(), n, UINT_MAX) == d);
+      REQUIRE(kernel::distance(u.data(), v.data(), n, d / 2) >= d / 2);
+      REQUIRE(kernel::distance(u.data(), v.data(), n, 1) >= 1);
+
+      // The distance is checked against the bound after every block of eight
+      // words.
+      for (unsigned int k = 8; k < n; k += 8) {
+        unsigned int b = kernel::distance(u.data(), v.data(), k);
+
+        REQUIRE(kernel::distance(u.data(), v.data(), n, b) == b);
+      }
+    }
+  }
+
+  kernel::select(kernel::best());
+}
+
+TEST_CASE(".weight counts the bits set in a vector") {
+  kernel::word v[] = {0xff00000000000001, 0x0000000000000003};
+
+  REQUIRE(kernel::weight(v, 2) == 11);
+  REQUIRE(kernel::weight(v, 1) == 9);
+}
+
+TEST_CASE(".extract gathers the bits selected by masks into a compact key") {
+  kernel::word v[] = {0xf0f0000000000000, 0x8000000000000001};
+  kernel::mask ms[] = {{0, 0x3c00000000000000}, {1, 0x8000000000000003}};
+
+  for (kernel::isa i: isas) {
+    if (!kernel::supported(i)) {
+      continue;
+    }
+
+    kernel::select(i);
+
+    REQUIRE(kernel::extract(v, ms, 2) == 0x65);
+    REQUIRE(kernel::extract(v, ms, 1) == 0xc);
+    REQUIRE(kernel::extract(v, ms, 0) == 0);
+  }
+
+  kernel::select(kernel::best());
+}
+
+TEST_CASE(".decode restores ids encoded with .encode with every instruction set") {
+  std::vector<unsigned int> ids;
+
+  unsigned int l = 0;
+
+  // Mix differences of every byte length.
+  for (unsigned int i = 0; i < 61; i++) {
+    ids.push_back(l += 1 + (i * 2654435761u >> (8 * (i % 4) + 5)) % (1u << (8 * (i % 4))));
+  }
+
+  ids.push_back(UINT_MAX);
+
+  for (unsigned int n = 0; n <= ids.size(); n++) {
+    std::vector<std::uint8_t> e((n + 3) / 4 + 4 * n + 16);
+
+    std::size_t m = kernel::encode(ids.data(), n, e.data());
+
+    REQUIRE(m <= (n + 3) / 4 + 4 * n);
+
+    for (kernel::isa i: isas) {
+      if (!kernel::supported(i)) {
+        continue;
+      }
+
+      kernel::select(i);
+
+      std::vector<unsigned int> d(n);
+
+      REQUIRE(kernel::decode(e.data(), n, d.data()) == m);
+      REQUIRE(d == std::vector<unsigned int>(ids.begin(), ids.begin() + n));
+    }
+  }
+
+  kernel::select(kernel::best());
+}
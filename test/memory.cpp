@@ -0,0 +1,172 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <test.hpp>
+#include <hemingway/memory.hpp>
+#include <hemingway/table.hpp>
+#include <hemingway/basic_table.hpp>
+
+/**
+ * A resource that counts the bytes allocated from it, from any number of
+ * threads.
+ */
+struct counting: lsh::memory_resource {
+  std::atomic<std::size_t> allocated{0};
+  std::atomic<std::size_t> deallocated{0};
+
+  void* allocate(std::size_t n, std::size_t a) {
+    this->allocated += n;
+
+    return lsh::default_resource()->allocate(n, a);
+  }
+
+  void deallocate(void* p, std::size_t n, std::size_t a) {
+    this->deallocated += n;
+
+    lsh::default_resource()->deallocate(p, n, a);
+  }
+};
+
+TEST_CASE("Arenas hand out aligned blocks from chunks") {
+  counting c;
+
+  {
+    lsh::arena a(64, &c);
+
+    char* p = static_cast<char*>(a.allocate(10, 1));
+    char* q = static_cast<char*>(a.allocate(8, 8));
+
+    REQUIRE(std::uintptr_t(q) % 8 == 0);
+    REQUIRE(std::uintptr_t(q) >= std::uintptr_t(p) + 10);
+    REQUIRE(a.size() == 64);
+
+    // A block larger than the next chunk gets a chunk of its own.
+    void* r = a.allocate(1000, 64);
+
+    REQUIRE(std::uintptr_t(r) % 64 == 0);
+    REQUIRE(a.size() >= 64 + 1000);
+
+    a.deallocate(r, 1000, 64);
+
+    REQUIRE(c.deallocated == 0);
+
+    a.release();
+
+    REQUIRE(a.size() == 0);
+    REQUIRE(c.deallocated == c.allocated);
+
+    a.allocate(10, 1);
+  }
+
+  REQUIRE(c.deallocated == c.allocated);
+}
+
+TEST_CASE("Huge page resources map large blocks aligned to huge pages") {
+  counting c;
+
+  lsh::huge_pages h(&c);
+
+  void* p = h.allocate(100, 8);
+
+  REQUIRE(c.allocated == 100);
+
+  h.deallocate(p, 100, 8);
+
+  std::size_t n = lsh::huge_pages::page + 1;
+
+  char* q = static_cast<char*>(h.allocate(n, 4096));
+
+  REQUIRE(c.allocated == 100);
+  REQUIRE(std::uintptr_t(q) % lsh::huge_pages::page == 0);
+
+  std::memset(q, 1, n);
+
+  h.deallocate(q, n, 4096);
+}
+
+TEST_CASE("Allocators allocate from their resource") {
+  counting c;
+
+  std::vector<int, lsh::allocator<int>> v(&c);
+
+  v.assign(100, 1);
+
+  REQUIRE(c.allocated >= 100 * sizeof(int));
+
+  // Copies use the heap, such that they do not depend on the resource.
+  std::vector<int, lsh::allocator<int>> w = v;
+
+  REQUIRE(w.get_allocator().resource() == lsh::default_resource());
+  REQUIRE(w == v);
+}
+
+TEST_CASE("Tables allocate their internals from their resource") {
+  counting c;
+
+  lsh::generator g(5);
+
+  std::vector<lsh::vector> vs = lsh::vector::random_batch(64, 500, g);
+
+  {
+    lsh::table t({.dimensions = 64, .samples = 8, .partitions = 4, .seed = 1, .resource = &c});
+    lsh::table r({.dimensions = 64, .samples = 8, .partitions = 4, .seed = 1});
+
+    t.insert_batch(vs.data(), 250);
+
+    // Batch inserts key every vector in every partition before filling it.
+    REQUIRE(c.allocated >= 250 * 4 * sizeof(std::uint64_t));
+
+    for (unsigned int i = 250; i < 500; i++) {
+      t.insert(vs[i]);
+    }
+
+    r.insert_batch(vs.data(), vs.size());
+
+    std::size_t n = c.allocated;
+
+    // Every bucket holds its ids in an allocation of its own.
+    REQUIRE(n >= vs.size() * 4 * sizeof(unsigned int));
+
+    lsh::table u = t;
+
+    REQUIRE(c.allocated == n);
+
+    t.freeze();
+
+    REQUIRE(c.allocated > n);
+
+    for (unsigned int i = 0; i < 500; i++) {
+      REQUIRE(t.query_nearest(vs[i]).distance == 0);
+      REQUIRE(u.query_nearest(vs[i]).distance == 0);
+    }
+  }
+
+  REQUIRE(c.deallocated == c.allocated);
+
+  {
+    lsh::arena a;
+
+    lsh::table t({.dimensions = 64, .radius = 2, .seed = 1, .resource = &a});
+
+    t.insert_batch(vs.data(), vs.size());
+    t.freeze();
+
+    REQUIRE(a.size() > 0);
+
+    for (unsigned int i = 0; i < 500; i++) {
+      REQUIRE(t.query_nearest(vs[i]).distance == 0);
+    }
+  }
+
+  {
+    counting d;
+
+    lsh::basic_table<64> t((lsh::basic_table<64>::brute({.resource = &d})));
+
+    t.insert(lsh::basic_vector<64>::random());
+
+    REQUIRE(d.allocated > 0);
+  }
+}
@@ -0,0 +1,138 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <test.hpp>
+#include <hemingway/pool.hpp>
+
+TEST_CASE("#size returns the number of workers in a pool") {
+  lsh::pool p(3);
+
+  REQUIRE(p.size() == 3);
+}
+
+TEST_CASE("#run runs every task on its assigned worker") {
+  lsh::pool p(4);
+
+  std::vector<unsigned int> ws(100, 100);
+
+  p.run(100, [&](unsigned int i, unsigned int w) {
+    ws[i] = w;
+  });
+
+  for (unsigned int i = 0; i < 100; i++) {
+    REQUIRE(ws[i] == i % 4);
+  }
+}
+
+TEST_CASE("#run can be called repeatedly") {
+  lsh::pool p(2);
+
+  std::atomic<unsigned int> n(0);
+
+  for (unsigned int i = 0; i < 50; i++) {
+    p.run(7, [&](unsigned int, unsigned int) {
+      n++;
+    });
+  }
+
+  REQUIRE(n == 350);
+}
+
+TEST_CASE("#run can be called from several threads at once") {
+  lsh::pool p(3);
+
+  std::atomic<unsigned int> n(0);
+  std::atomic<bool> pinned(true);
+
+  std::vector<std::thread> ts;
+
+  for (unsigned int t = 0; t < 4; t++) {
+    ts.push_back(std::thread([&] {
+      for (unsigned int i = 0; i < 50; i++) {
+        p.run(10, [&](unsigned int j, unsigned int w) {
+          pinned = pinned && w == j % 3;
+          n++;
+        });
+      }
+    }));
+  }
+
+  for (std::thread& t: ts) {
+    t.join();
+  }
+
+  REQUIRE(n == 2000);
+  REQUIRE(pinned);
+}
+
+TEST_CASE("#run does not wait for batches started by other threads") {
+  lsh::pool p(2);
+
+  std::atomic<bool> done(false);
+
+  // The first batch only occupies the first worker until the second batch
+  // has run on the second worker.
+  std::thread t([&] {
+    p.run(1, [&](unsigned int, unsigned int) {
+      while (!done) {
+        std::this_thread::yield();
+      }
+    });
+  });
+
+  p.run(2, [&](unsigned int i, unsigned int) {
+    if (i == 1) {
+      done = true;
+    }
+  });
+
+  t.join();
+
+  REQUIRE(done);
+}
+
+TEST_CASE("#run rethrows exceptions thrown by tasks") {
+  lsh::pool p(2);
+
+  REQUIRE_THROWS_AS(p.run(5, [](unsigned int i, unsigned int) {
+    if (i == 3) {
+      throw std::runtime_error("Task failed");
+    }
+  }), std::runtime_error);
+}
+
+TEST_CASE("#run_on runs a task on its worker only") {
+  lsh::pool p(3);
+
+  std::vector<std::thread::id> ids(3);
+
+  p.run(3, [&](unsigned int, unsigned int w) {
+    ids[w] = std::this_thread::get_id();
+  });
+
+  std::atomic<bool> done(false);
+
+  // The first worker is occupied until the task has run on the last worker,
+  // so the task cannot involve the first worker.
+  std::thread t([&] {
+    p.run(1, [&](unsigned int, unsigned int) {
+      while (!done) {
+        std::this_thread::yield();
+      }
+    });
+  });
+
+  std::thread::id id;
+
+  p.run_on(2, [&] {
+    id = std::this_thread::get_id();
+    done = true;
+  });
+
+  t.join();
+
+  REQUIRE(id == ids[2]);
+  REQUIRE_THROWS_AS(p.run_on(3, [] {}), std::out_of_range);
+}
@@ -0,0 +1,148 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <atomic>
+#include <climits>
+#include <stdexcept>
+#include <thread>
+#include <test.hpp>
+#include <hemingway/vector.hpp>
+#include <hemingway/sharded_table.hpp>
+
+TEST_CASE("Sharded tables route vectors to their shards") {
+  lsh::sharded_table t({.dimensions = 64, .radius = 2}, 4);
+
+  std::vector<lsh::vector> vs;
+
+  for (unsigned int i = 0; i < 200; i++) {
+    vs.push_back(lsh::vector::random(64));
+  }
+
+  std::vector<unsigned int> is = t.insert_batch(vs.data(), 100);
+
+  for (unsigned int i = 100; i < 200; i++) {
+    is.push_back(t.insert(vs[i]));
+  }
+
+  REQUIRE(t.shards() == 4);
+  REQUIRE(t.size() == 200);
+  REQUIRE(t.stats().partitions == 4 * 7);
+
+  for (unsigned int i = 0; i < 200; i++) {
+    REQUIRE(is[i] % 4 == vs[i].hash() % 4);
+    REQUIRE(t.query_nearest(vs[i]).id == is[i]);
+    REQUIRE(t.query_nearest(vs[i]).distance == 0);
+    REQUIRE(t.query_any(vs[i], 0).id == is[i]);
+    REQUIRE(t.query_k(vs[i], 3)[0].id == is[i]);
+    REQUIRE(t.query_radius(vs[i], 0).size() == 1);
+  }
+
+  // Each query is counted by all 4 shards, one of which finds at least the
+  // vector the query was made from.
+  REQUIRE(t.stats().totals.candidates >= t.stats().queries / 4);
+
+  std::vector<lsh::table::result> rs(200);
+
+  t.query_batch(vs.data(), 200, rs.data());
+
+  for (unsigned int i = 0; i < 200; i++) {
+    REQUIRE(rs[i].id == is[i]);
+  }
+
+  REQUIRE(t.erase(is[0]));
+  REQUIRE(t.erase(vs[1]));
+  REQUIRE_FALSE(t.erase(vs[1]));
+  REQUIRE(t.size() == 198);
+  REQUIRE(t.query_nearest(vs[0]).id != is[0]);
+}
+
+TEST_CASE("Sharded tables merge the results of their shards") {
+  lsh::sharded_table t(lsh::table::brute({.dimensions = 64}), 3);
+
+  std::vector<lsh::vector> vs;
+
+  for (unsigned int i = 0; i < 30; i++) {
+    vs.push_back(lsh::vector::random(64));
+    t.insert(vs[i]);
+  }
+
+  t.freeze();
+
+  lsh::vector q = lsh::vector::random(64);
+
+  std::vector<lsh::table::result> rs = t.query_k(q, 30);
+
+  REQUIRE(rs.size() == 30);
+
+  for (unsigned int i = 1; i < 30; i++) {
+    REQUIRE(rs[i - 1].distance <= rs[i].distance);
+  }
+
+  REQUIRE(t.query_nearest(q).distance == rs[0].distance);
+  REQUIRE(t.query_k(q, 5).size() == 5);
+}
+
+TEST_CASE("Sharded tables can be modified and queried from several threads") {
+  lsh::sharded_table t({.dimensions = 64, .samples = 8, .partitions = 4}, 4);
+
+  std::vector<lsh::vector> ks;
+
+  for (unsigned int i = 0; i < 100; i++) {
+    ks.push_back(lsh::vector::random(64));
+  }
+
+  std::vector<unsigned int> is = t.insert_batch(ks.data(), ks.size());
+
+  std::atomic<unsigned int> misses(0);
+
+  std::vector<std::thread> threads;
+
+  for (unsigned int r = 0; r < 4; r++) {
+    threads.push_back(std::thread([&]() {
+      for (unsigned int i = 0; i < 100; i++) {
+        lsh::vector v = lsh::vector::random(64);
+
+        t.insert(v);
+
+        if (t.query_nearest(ks[i]).distance != 0) {
+          misses++;
+        }
+
+        if (!t.erase(v)) {
+          misses++;
+        }
+      }
+    }));
+  }
+
+  for (std::thread& x: threads) {
+    x.join();
+  }
+
+  REQUIRE(misses == 0);
+  REQUIRE(t.size() == 100);
+
+  for (unsigned int i = 0; i < 100; i++) {
+    REQUIRE(t.query_nearest(ks[i]).id == is[i]);
+  }
+}
+
+TEST_CASE("Sharded tables take back batches that fail to insert") {
+  lsh::sharded_table t({.dimensions = 64, .radius = 2}, 4);
+
+  std::vector<lsh::vector> vs;
+
+  for (unsigned int i = 0; i < 100; i++) {
+    vs.push_back(lsh::vector::random(i == 50 ? 32 : 64));
+  }
+
+  REQUIRE_THROWS_AS(t.insert_batch(vs.data(), vs.size()), std::invalid_argument);
+  REQUIRE(t.size() == 0);
+
+  vs.erase(vs.begin() + 50);
+
+  for (unsigned int i = 0; i < 99; i++) {
+    REQUIRE(t.query_nearest(vs[i]).id == UINT_MAX);
+  }
+
+  REQUIRE(t.insert_batch(vs.data(), vs.size()).size() == 99);
+  REQUIRE(t.size() == 99);
+}
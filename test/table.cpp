@@ -1,4 +1,7 @@
 // Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <cstdio>
+#include <fstream>
+#include <iterator>
 #include <test.hpp>
 #include <hemingway/vector.hpp>
 #include <hemingway/table.hpp>
@@ -42,3 +45,647 @@ TEST_CASE("#erase removes a vector from a table") {
   REQUIRE(t.query(v1) == v1);
   REQUIRE(t.query(v2) != v2);
 }
+
+TEST_CASE("#erase ignores vectors that are not in a table") {
+  lsh::table t({.dimensions = 4, .samples = 2, .partitions = 2});
+
+  t.insert(v1);
+  t.erase(v2);
+
+  REQUIRE(t.size() == 1);
+  REQUIRE(t.query(v1) == v1);
+}
+
+TEST_CASE("#insert reuses the slots of erased vectors") {
+  lsh::table t({.dimensions = 4, .samples = 2, .partitions = 2});
+
+  t.insert(v1);
+  t.erase(v1);
+  t.insert(v2);
+
+  REQUIRE(t.size() == 1);
+  REQUIRE(t.query(v2) == v2);
+  REQUIRE(t.stats().vectors == 2);
+}
+
+TEST_CASE("#insert keeps vectors with different projections in different buckets") {
+  lsh::table t({.dimensions = 4, .samples = 200, .partitions = 1});
+
+  for (unsigned int i = 0; i < 16; i++) {
+    t.insert(lsh::vector({bool(i & 8), bool(i & 4), bool(i & 2), bool(i & 1)}));
+  }
+
+  REQUIRE(t.stats().buckets == 16);
+}
+
+TEST_CASE("#stats breaks down the buckets and memory of a table") {
+  lsh::table t({.dimensions = 4, .samples = 200, .partitions = 3});
+
+  for (unsigned int i = 0; i < 16; i++) {
+    t.insert(lsh::vector({bool(i & 8), bool(i & 4), bool(i & 2), bool(i & 1)}));
+  }
+
+  t.insert(v1);
+
+  for (bool f: {false, true}) {
+    if (f) {
+      t.freeze();
+    }
+
+    lsh::table::statistics s = t.stats();
+
+    REQUIRE(s.histogram.size() == 2);
+    REQUIRE(s.histogram[0] == 15 * 3);
+    REQUIRE(s.histogram[1] == 3);
+    REQUIRE(s.largest == std::vector<unsigned int>(3, 2));
+    REQUIRE(s.mask_memory >= 3 * sizeof(lsh::kernel::mask));
+    REQUIRE(s.vector_memory >= 17 * sizeof(lsh::kernel::word));
+  }
+}
+
+TEST_CASE("#query finds every vector within the radius of a covering table") {
+  lsh::table t({.dimensions = 70, .radius = 2});
+
+  lsh::vector v = lsh::vector::random(70);
+
+  t.insert(v);
+
+  for (unsigned int i = 0; i < 70; i++) {
+    for (unsigned int j = i; j < 70; j++) {
+      std::vector<bool> c(70);
+
+      for (unsigned int k = 0; k < 70; k++) {
+        c[k] = v.get(k) ^ (k == i) ^ (k == j && j != i);
+      }
+
+      REQUIRE(t.query(lsh::vector(c)) == v);
+    }
+  }
+}
+
+TEST_CASE("Classic tables probe the buckets next to the bucket of a query") {
+  lsh::table t({.dimensions = 16, .samples = 16, .partitions = 1, .probes = 16 + 120});
+
+  std::vector<bool> c(16);
+
+  c[3] = c[8] = 1;
+
+  lsh::vector v(c);
+
+  t.insert(v);
+
+  for (unsigned int i = 0; i < 16; i++) {
+    for (unsigned int j = i; j < 16; j++) {
+      std::vector<bool> d = c;
+
+      d[i] = !d[i];
+      d[j] = i == j ? d[j] : !d[j];
+
+      REQUIRE(t.query_nearest(lsh::vector(d)).id == 0);
+    }
+  }
+
+  t.freeze();
+
+  std::vector<bool> d = c;
+
+  d[0] = d[15] = 1;
+
+  REQUIRE(t.query_nearest(lsh::vector(c)).id == 0);
+  REQUIRE(t.query_nearest(lsh::vector(d)).id == 0);
+
+  t.save("table.hmw");
+
+  lsh::table o = lsh::table::open("table.hmw");
+
+  REQUIRE(o.query_nearest(lsh::vector(d)).id == 0);
+
+  std::remove("table.hmw");
+}
+
+TEST_CASE("#freeze keeps the vectors of a table") {
+  lsh::table t({.dimensions = 4, .samples = 2, .partitions = 2});
+
+  t.insert(v1);
+  t.insert(v2);
+
+  lsh::table::statistics s = t.stats();
+
+  t.freeze();
+
+  REQUIRE(t.frozen());
+  REQUIRE(t.size() == 2);
+  REQUIRE(t.query(v1) == v1);
+  REQUIRE(t.query(v2) == v2);
+  REQUIRE(t.stats().buckets == s.buckets);
+  REQUIRE(t.stats().vectors == s.vectors);
+  REQUIRE(t.stats().memory + t.stats().saved == s.memory);
+}
+
+TEST_CASE("#freeze can compress the vector ids of buckets") {
+  lsh::generator g(17);
+
+  std::vector<lsh::vector> vs = lsh::vector::random_batch(64, 2000, g);
+  std::vector<lsh::vector> qs = lsh::vector::random_batch(64, 50, g);
+
+  qs.insert(qs.end(), vs.begin(), vs.begin() + 20);
+
+  lsh::table r({.dimensions = 64, .samples = 4, .partitions = 6, .seed = 9});
+
+  r.insert_batch(vs.data(), vs.size());
+
+  // Erase a few vectors such that the ids of the buckets are not in order.
+  for (unsigned int i = 100; i < 110; i++) {
+    r.erase(i);
+    r.insert(vs[i]);
+  }
+
+  lsh::table z = r;
+
+  r.freeze();
+  z.freeze(true);
+
+  lsh::table::statistics a = r.stats();
+  lsh::table::statistics b = z.stats();
+
+  REQUIRE(b.buckets == a.buckets);
+  REQUIRE(b.vectors == a.vectors);
+  REQUIRE(b.histogram == a.histogram);
+  REQUIRE(b.largest == a.largest);
+  REQUIRE(a.id_memory == a.raw_id_memory);
+  REQUIRE(b.raw_id_memory == a.raw_id_memory);
+  REQUIRE(b.id_memory < b.raw_id_memory / 2);
+  REQUIRE(b.memory < a.memory);
+
+  std::vector<lsh::table::result> rs(qs.size());
+
+  z.query_batch(qs.data(), qs.size(), rs.data(), 1);
+
+  for (unsigned int i = 0; i < qs.size(); i++) {
+    REQUIRE(z.query_nearest(qs[i]).distance == r.query_nearest(qs[i]).distance);
+    REQUIRE(rs[i].distance == r.query_nearest(qs[i]).distance);
+    REQUIRE(z.query_radius(qs[i], 20).size() == r.query_radius(qs[i], 20).size());
+  }
+}
+
+TEST_CASE("#freeze prevents a table from being modified") {
+  lsh::table t({.dimensions = 4, .samples = 2, .partitions = 2});
+
+  t.insert(v1);
+  t.freeze();
+
+  REQUIRE_THROWS_AS(t.insert(v2), std::logic_error);
+  REQUIRE_THROWS_AS(t.erase(v1), std::logic_error);
+}
+
+TEST_CASE("Views of packed words can be inserted into and queried from a table") {
+  lsh::table t({.dimensions = 64, .radius = 2});
+
+  lsh::kernel::word ws[] = {0x0123456789abcdef, 0xfedcba9876543210};
+
+  unsigned int u = t.insert(lsh::vector_view(ws, 64));
+  unsigned int v = t.insert(lsh::vector_view(ws + 1, 64));
+
+  REQUIRE(t.query_nearest(lsh::vector_view(ws, 64)).id == u);
+  REQUIRE(t.query_nearest(lsh::vector_view(ws + 1, 64)).id == v);
+  REQUIRE(t.query(lsh::vector_view(ws, 64)) == lsh::vector(ws, 64));
+  REQUIRE(t.erase(lsh::vector_view(ws, 64)));
+  REQUIRE(t.size() == 1);
+}
+
+TEST_CASE("Tables constructed with the same seed are identical") {
+  lsh::generator g(11);
+
+  std::vector<lsh::vector> vs = lsh::vector::random_batch(100, 50, g);
+
+  std::vector<std::string> fs;
+
+  for (unsigned int i = 0; i < 8; i++) {
+    std::uint64_t s = i < 4 ? 5 : 0;
+
+    lsh::table t = i % 4 < 2
+      ? lsh::table({.dimensions = 100, .samples = 10, .partitions = 4, .seed = s})
+      : lsh::table({.dimensions = 100, .radius = 2, .seed = s});
+
+    t.insert_batch(vs.data(), vs.size());
+    t.save("table.hmw");
+
+    std::ifstream f("table.hmw", std::ios::binary);
+
+    fs.push_back(std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()));
+
+    std::remove("table.hmw");
+  }
+
+  REQUIRE(fs[0] == fs[1]);
+  REQUIRE(fs[2] == fs[3]);
+  REQUIRE(fs[4] == fs[5]);
+  REQUIRE(fs[6] == fs[7]);
+}
+
+TEST_CASE("#open reads a table written by #save") {
+  lsh::table c({.dimensions = 100, .radius = 2});
+  lsh::table s({.dimensions = 100, .samples = 10, .partitions = 4});
+
+  std::vector<lsh::vector> vs;
+
+  for (unsigned int i = 0; i < 50; i++) {
+    vs.push_back(lsh::vector::random(100));
+    c.insert(vs[i]);
+    s.insert(vs[i]);
+  }
+
+  lsh::table z = s;
+
+  s.freeze();
+  z.freeze(true);
+
+  for (lsh::table* t: {&c, &s, &z}) {
+    t->save("table.hmw");
+
+    lsh::table o = lsh::table::open("table.hmw");
+
+    std::remove("table.hmw");
+
+    REQUIRE(o.frozen());
+    REQUIRE(o.size() == t->size());
+    REQUIRE(o.stats().buckets == t->stats().buckets);
+    REQUIRE(o.stats().vectors == t->stats().vectors);
+
+    for (unsigned int i = 0; i < 50; i++) {
+      REQUIRE(o.query_nearest(vs[i]).id == t->query_nearest(vs[i]).id);
+    }
+
+    REQUIRE_THROWS_AS(o.insert(vs[0]), std::logic_error);
+  }
+
+  REQUIRE_THROWS_AS(lsh::table::open("missing.hmw"), std::runtime_error);
+}
+
+TEST_CASE("#open rejects a truncated file") {
+  lsh::table c({.dimensions = 100, .radius = 2});
+  lsh::table s({.dimensions = 100, .samples = 10, .partitions = 4});
+
+  for (unsigned int i = 0; i < 50; i++) {
+    lsh::vector v = lsh::vector::random(100);
+
+    c.insert(v);
+    s.insert(v);
+  }
+
+  lsh::table z = s;
+
+  z.freeze(true);
+
+  for (lsh::table* t: {&c, &s, &z}) {
+    t->save("table.hmw");
+
+    std::ifstream i("table.hmw", std::ios::binary);
+    std::string d((std::istreambuf_iterator<char>(i)), std::istreambuf_iterator<char>());
+
+    for (std::size_t n: {std::size_t(0), std::size_t(100), d.size() / 2, d.size() - 4096, d.size() - 1}) {
+      std::ofstream o("table.hmw", std::ios::binary | std::ios::trunc);
+
+      o.write(d.data(), n);
+      o.close();
+
+      REQUIRE_THROWS_AS(lsh::table::open("table.hmw"), std::runtime_error);
+    }
+
+    std::remove("table.hmw");
+  }
+}
+
+TEST_CASE("#open rejects a covering table that probes extra buckets") {
+  lsh::table c({.dimensions = 100, .radius = 2});
+
+  c.insert(lsh::vector::random(100));
+  c.save("table.hmw");
+
+  std::fstream f("table.hmw", std::ios::binary | std::ios::in | std::ios::out);
+
+  // The number of extra probes follows the magic, version, byte order,
+  // dimensions, size, partitions, samples and basis.
+  std::uint64_t p = 1;
+
+  f.seekp(56);
+  f.write(reinterpret_cast<const char*>(&p), sizeof(p));
+  f.close();
+
+  REQUIRE_THROWS_AS(lsh::table::open("table.hmw"), std::runtime_error);
+
+  std::remove("table.hmw");
+}
+
+TEST_CASE("#insert_batch adds a number of vectors to a table") {
+  lsh::table c({.dimensions = 100, .radius = 3});
+  lsh::table s = c;
+
+  std::vector<lsh::vector> vs;
+
+  for (unsigned int i = 0; i < 200; i++) {
+    vs.push_back(lsh::vector::random(100));
+  }
+
+  std::vector<unsigned int> us = c.insert_batch(vs.data(), vs.size(), 4);
+
+  for (const lsh::vector& v: vs) {
+    s.insert(v);
+  }
+
+  REQUIRE(us.size() == 200);
+
+  REQUIRE(c.size() == 200);
+  REQUIRE(c.stats().buckets == s.stats().buckets);
+  REQUIRE(c.stats().vectors == s.stats().vectors);
+
+  for (unsigned int i = 0; i < 200; i++) {
+    REQUIRE(c.query(vs[i]) == vs[i]);
+    REQUIRE(c.query_nearest(vs[i]).id == us[i]);
+  }
+}
+
+TEST_CASE("#query_batch queries a table for a number of vectors") {
+  lsh::table t({.dimensions = 4, .samples = 2, .partitions = 2});
+
+  t.insert(v1);
+
+  lsh::vector qs[] = {v1, v1, lsh::vector({0, 1, 1, 0})};
+  lsh::table::result rs[3];
+
+  t.query_batch(qs, 3, rs, 2);
+
+  REQUIRE(rs[0].id == 0);
+  REQUIRE(rs[0].distance == 0);
+  REQUIRE(rs[1].id == 0);
+  REQUIRE(rs[1].distance == 0);
+  REQUIRE(rs[2].distance >= 4);
+}
+
+TEST_CASE("#query_batch finds the same neighbours in a frozen table") {
+  lsh::generator g(23);
+
+  std::vector<lsh::vector> vs = lsh::vector::random_batch(128, 500, g);
+  std::vector<lsh::vector> qs = lsh::vector::random_batch(128, 100, g);
+
+  // Include queries with exact matches, which stop probing early.
+  qs.insert(qs.end(), vs.begin(), vs.begin() + 37);
+
+  lsh::table t({.dimensions = 128, .samples = 6, .partitions = 8, .seed = 3});
+
+  t.insert_batch(vs.data(), vs.size());
+  t.freeze();
+
+  std::vector<lsh::table::result> rs(qs.size());
+
+  t.query_batch(qs.data(), qs.size(), rs.data(), 1);
+
+  lsh::table::counters a = t.stats().totals;
+
+  for (unsigned int i = 0; i < qs.size(); i++) {
+    lsh::table::result r = t.query_nearest(qs[i]);
+
+    REQUIRE(rs[i].id == r.id);
+    REQUIRE(rs[i].distance == r.distance);
+  }
+
+  lsh::table::counters b = t.stats().totals;
+
+  // Both ways of querying verify the same candidates, though batched queries
+  // look up the buckets of every partition before verifying any of them.
+  REQUIRE(b.probes - a.probes <= a.probes);
+  REQUIRE(b.candidates - a.candidates == a.candidates);
+  REQUIRE(b.duplicates - a.duplicates == a.duplicates);
+  REQUIRE(b.distances - a.distances == a.distances);
+  REQUIRE(b.pruned - a.pruned == a.pruned);
+
+  if (lsh::table::counting) {
+    REQUIRE(a.probes > 0);
+    REQUIRE(a.lookup > 0);
+    REQUIRE(a.verification > 0);
+  }
+}
+
+TEST_CASE("#query verifies each candidate only once") {
+  lsh::table t({.dimensions = 4, .radius = 3});
+
+  t.insert(v1);
+
+  lsh::table::counters cs;
+
+  REQUIRE(t.query(lsh::vector({1, 0, 0, 0}), cs) == v1);
+  REQUIRE(cs.candidates >= 7);
+  REQUIRE(cs.duplicates == cs.candidates - 1);
+}
+
+TEST_CASE("#query counts probes and distances when counters are compiled in") {
+  lsh::table t({.dimensions = 4, .radius = 3});
+
+  t.insert(v1);
+
+  lsh::table::counters cs;
+
+  t.query(lsh::vector({1, 0, 0, 0}), cs);
+  t.query(lsh::vector({0, 1, 0, 0}));
+
+  lsh::table::statistics s = t.stats();
+
+  if (lsh::table::counting) {
+    REQUIRE(cs.probes == s.partitions);
+    REQUIRE(cs.distances == cs.candidates - cs.duplicates);
+    REQUIRE(s.queries == 2);
+    REQUIRE(s.totals.probes == 2 * s.partitions);
+  } else {
+    REQUIRE(cs.probes == 0);
+    REQUIRE(cs.distances == 0);
+    REQUIRE(s.queries == 0);
+    REQUIRE(s.totals.probes == 0);
+  }
+}
+
+TEST_CASE("#query skips candidates that cannot beat the best candidate") {
+  lsh::generator g(13);
+
+  std::vector<lsh::vector> vs = lsh::vector::random_batch(2048, 200, g);
+
+  lsh::table t(lsh::table::brute({.dimensions = 2048}));
+  lsh::table u({.dimensions = 2048, .samples = 1, .partitions = 2});
+
+  t.insert_batch(vs.data(), vs.size());
+  u.insert_batch(vs.data(), vs.size());
+
+  for (unsigned int i = 0; i < 20; i++) {
+    lsh::vector q = lsh::vector::random(2048, g);
+
+    std::vector<lsh::table::result> rs = t.query_k(q, 200);
+
+    lsh::table::counters cs;
+
+    t.query(q, cs);
+
+    REQUIRE(t.query_nearest(q).id == rs[0].id);
+    REQUIRE(t.query_k(q, 5)[4].id == rs[4].id);
+    REQUIRE(t.query_radius(q, rs[9].distance).size() >= 10);
+
+    if (lsh::table::counting) {
+      REQUIRE(cs.pruned > 0);
+    }
+
+    u.freeze();
+
+    lsh::table::result r = u.query_nearest(q);
+
+    REQUIRE(r.distance == lsh::vector::distance(q, vs[r.id]));
+  }
+}
+
+TEST_CASE("#query skips candidates whose weight is too far off") {
+  lsh::table t(lsh::table::brute({.dimensions = 1024}));
+
+  for (unsigned int i = 0; i < 100; i++) {
+    std::vector<bool> c(1024);
+
+    for (unsigned int j = 0; j < 10 * i; j++) {
+      c[j] = 1;
+    }
+
+    t.insert(lsh::vector(c));
+  }
+
+  t.freeze();
+
+  lsh::table::counters cs;
+
+  std::vector<bool> c(1024);
+
+  c[0] = 1;
+
+  lsh::vector q(c);
+
+  REQUIRE(t.query_nearest(q).id == 0);
+  REQUIRE(t.query_k(q, 3)[2].id == 2);
+  REQUIRE(t.query_radius(q, 19).size() == 3);
+
+  t.query(q, cs);
+
+  if (lsh::table::counting) {
+    REQUIRE(cs.pruned + cs.distances >= 99);
+    REQUIRE(cs.distances < 99);
+  }
+}
+
+TEST_CASE("#query_k returns the k nearest neighbours of a vector") {
+  lsh::table t(lsh::table::brute({.dimensions = 4}));
+
+  t.insert(lsh::vector({1, 1, 1, 1}));
+  t.insert(lsh::vector({0, 0, 0, 1}));
+  t.insert(lsh::vector({0, 0, 0, 0}));
+  t.insert(lsh::vector({0, 0, 1, 1}));
+
+  std::vector<lsh::table::result> rs = t.query_k(lsh::vector({0, 0, 0, 0}), 3);
+
+  REQUIRE(rs.size() == 3);
+  REQUIRE(rs[0].id == 2);
+  REQUIRE(rs[0].distance == 0);
+  REQUIRE(rs[1].id == 1);
+  REQUIRE(rs[1].distance == 1);
+  REQUIRE(rs[2].id == 3);
+  REQUIRE(rs[2].distance == 2);
+
+  REQUIRE(t.query_k(v1, 10).size() == 4);
+}
+
+TEST_CASE("#query_radius returns the neighbours of a vector within a radius") {
+  lsh::table t(lsh::table::brute({.dimensions = 4}));
+
+  t.insert(lsh::vector({1, 1, 1, 1}));
+  t.insert(lsh::vector({0, 0, 0, 1}));
+  t.insert(lsh::vector({0, 0, 1, 1}));
+
+  std::vector<lsh::table::result> rs = t.query_radius(lsh::vector({0, 0, 0, 0}), 2);
+
+  REQUIRE(rs.size() == 2);
+  REQUIRE(rs[0].id == 1);
+  REQUIRE(rs[1].id == 2);
+}
+
+TEST_CASE("#query_any stops at the first neighbour within a radius") {
+  lsh::table t(lsh::table::brute({.dimensions = 4}));
+
+  t.insert(lsh::vector({0, 0, 1, 1}));
+  t.insert(lsh::vector({0, 0, 0, 0}));
+
+  lsh::table::result r = t.query_any(lsh::vector({0, 0, 0, 0}), 2);
+
+  REQUIRE(r.id == 0);
+  REQUIRE(r.distance == 2);
+
+  r = t.query_any(lsh::vector({0, 0, 0, 0}), 1);
+
+  REQUIRE(r.id == 1);
+  REQUIRE(r.distance == 0);
+}
+
+TEST_CASE("#query stops probing partitions once an exact match is found") {
+  lsh::table t({.dimensions = 4, .radius = 3});
+
+  t.insert(v1);
+
+  lsh::table::counters cs;
+
+  REQUIRE(t.query(v1, cs) == v1);
+  REQUIRE(cs.candidates == 1);
+}
+
+TEST_CASE("#erase removes a vector with a given id from a table") {
+  lsh::table t(lsh::table::brute({.dimensions = 4}));
+
+  std::vector<lsh::vector> vs;
+
+  for (unsigned int i = 0; i < 5; i++) {
+    vs.push_back(lsh::vector({bool(i & 4), bool(i & 2), bool(i & 1), 1}));
+    t.insert(vs[i]);
+  }
+
+  REQUIRE(t.erase(1u));
+  REQUIRE(t.erase(vs[3]));
+  REQUIRE(!t.erase(1u));
+  REQUIRE(!t.erase(vs[3]));
+  REQUIRE(!t.erase(9u));
+
+  REQUIRE(t.size() == 3);
+  REQUIRE(t.stats().vectors == 3);
+
+  for (unsigned int i: {0, 2, 4}) {
+    REQUIRE(t.query(vs[i]) == vs[i]);
+  }
+
+  REQUIRE(t.query_radius(vs[1], 0).empty());
+  REQUIRE(t.query_radius(vs[3], 0).empty());
+}
+
+TEST_CASE("#insert returns the id of a vector") {
+  lsh::table t({.dimensions = 4, .samples = 2, .partitions = 2});
+
+  unsigned int u1 = t.insert(v1);
+  unsigned int u2 = t.insert(v2);
+
+  REQUIRE(u1 != u2);
+  REQUIRE(t.query_nearest(v1).id == u1);
+  REQUIRE(t.query_nearest(v1).distance == 0);
+  REQUIRE(t.query_nearest(v2).id == u2);
+
+  t.erase(u1);
+
+  REQUIRE(t.insert(v1) == u1);
+  REQUIRE(t.query_nearest(v2).id == u2);
+}
+
+TEST_CASE("#query_nearest reports when no neighbour was found") {
+  lsh::table t({.dimensions = 4, .samples = 4, .partitions = 1});
+
+  lsh::table::result r = t.query_nearest(v1);
+
+  REQUIRE(r.id == UINT_MAX);
+  REQUIRE(r.distance == UINT_MAX);
+}
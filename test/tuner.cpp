@@ -0,0 +1,102 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <test.hpp>
+#include <hemingway/vector.hpp>
+#include <hemingway/table.hpp>
+#include <hemingway/tuner.hpp>
+
+/**
+ * Create a sample of clusters of vectors, each vector being at most one bit
+ * away from the center of its cluster.
+ */
+std::vector<lsh::vector> clusters(unsigned int n, unsigned int size) {
+  std::vector<lsh::vector> vs;
+
+  for (unsigned int i = 0; i < n; i++) {
+    lsh::vector c = lsh::vector::random(64);
+
+    for (unsigned int j = 0; j < size; j++) {
+      std::vector<bool> b(64);
+
+      for (unsigned int k = 0; k < 64; k++) {
+        b[k] = c.get(k) ^ (k == (i * size + j) % 64);
+      }
+
+      vs.push_back(lsh::vector(b));
+    }
+  }
+
+  return vs;
+}
+
+TEST_CASE("Tuners measure the recall of configurations") {
+  lsh::tuner t(clusters(100, 4), 2, 0.9);
+
+  REQUIRE(t.measure(lsh::table::covering({.dimensions = 64, .radius = 2})).recall == 1);
+  REQUIRE(t.measure(lsh::table::classic({.dimensions = 64, .samples = 1, .partitions = 8})).recall == 1);
+  REQUIRE(t.measure(lsh::table::classic({.dimensions = 64, .samples = 64, .partitions = 1})).recall < 0.9);
+}
+
+TEST_CASE("Tuners find configurations that meet the recall target") {
+  lsh::tuner t(clusters(100, 4), 2, 0.9);
+
+  lsh::table::classic c = t.classic();
+  lsh::table::covering v = t.covering();
+
+  REQUIRE(c.dimensions == 64);
+  REQUIRE(c.samples >= 1);
+  REQUIRE(c.samples < 64);
+  REQUIRE(v.dimensions == 64);
+  REQUIRE(v.radius <= 2);
+
+  lsh::table u = t.tune();
+
+  REQUIRE(u.size() == 0);
+  REQUIRE(u.stats().partitions >= 1);
+}
+
+TEST_CASE("Tuners constructed with the same seed find the same configurations") {
+  std::vector<lsh::vector> vs = clusters(100, 4);
+
+  lsh::tuner t(vs, 2, 0.9, 0, 7);
+  lsh::tuner u(vs, 2, 0.9, 0, 7);
+
+  double a;
+  double b;
+
+  lsh::table::classic c = t.classic(&a);
+  lsh::table::classic d = u.classic(&b);
+
+  REQUIRE(c.samples == d.samples);
+  REQUIRE(c.partitions == d.partitions);
+  REQUIRE(c.seed == 7);
+  REQUIRE(d.seed == 7);
+  REQUIRE(a == b);
+  REQUIRE(t.measure(c).cost == a);
+
+  lsh::table::covering v = t.covering(&a);
+  lsh::table::covering w = u.covering(&b);
+
+  REQUIRE(v.radius == w.radius);
+  REQUIRE(v.seed == 7);
+  REQUIRE(a == b);
+  REQUIRE(t.measure(v).cost == a);
+}
+
+TEST_CASE("Tuners reject samples without neighbours within the radius") {
+  std::vector<lsh::vector> vs;
+
+  for (unsigned int i = 0; i < 100; i++) {
+    vs.push_back(lsh::vector::random(256));
+  }
+
+  REQUIRE_THROWS_AS(lsh::tuner(vs, 2, 0.9), std::invalid_argument);
+  REQUIRE_THROWS_AS(lsh::tuner(vs, 2, 0.9, 100), std::invalid_argument);
+  REQUIRE_THROWS_AS(lsh::tuner(vs, 2, 1.5), std::invalid_argument);
+}
+
+TEST_CASE("Tuners reject radii too wide to cover") {
+  std::vector<lsh::vector> vs = clusters(100, 4);
+
+  REQUIRE_THROWS_AS(lsh::tuner(vs, 13, 0.9), std::invalid_argument);
+  REQUIRE_NOTHROW(lsh::tuner(vs, 12, 0.9));
+}
@@ -15,6 +15,30 @@ TEST_CASE("#get returns the component at a specified index of a vector") {
   REQUIRE(v.get(3) == 1);
 }
 
+TEST_CASE("#get returns the components of vectors spanning several chunks") {
+  std::vector<bool> c(100);
+
+  c[0] = c[63] = c[64] = c[99] = 1;
+
+  lsh::vector w(c);
+
+  for (unsigned int i = 0; i < 100; i++) {
+    REQUIRE(w.get(i) == c[i]);
+  }
+}
+
+TEST_CASE("Vectors can be created from packed words and bytes") {
+  std::vector<bool> c(100);
+
+  c[0] = c[7] = c[63] = c[64] = c[99] = 1;
+
+  lsh::kernel::word ws[] = {0x8100000000000001, 0x800000001 | 0xf000000000000000};
+  std::uint8_t bs[] = {0x81, 0, 0, 0, 0, 0, 0, 0x01, 0x80, 0, 0, 0, 0x10};
+
+  REQUIRE(lsh::vector(ws, 100) == lsh::vector(c));
+  REQUIRE(lsh::vector(bs, 100) == lsh::vector(c));
+}
+
 TEST_CASE("#to_string returns the string representation of a vector") {
   REQUIRE(v.to_string() == "Vector[1001]");
 }
@@ -65,3 +89,18 @@ TEST_CASE(".distance computes the distance between two vectors") {
 
   REQUIRE(lsh::vector::distance(v1, v2) == 2);
 }
+
+TEST_CASE(".random generates the same vectors from the same seed") {
+  lsh::generator g(7);
+  lsh::generator h(7);
+
+  std::vector<lsh::vector> vs = lsh::vector::random_batch(70, 10, g);
+
+  REQUIRE(vs.size() == 10);
+
+  for (const lsh::vector& v: vs) {
+    REQUIRE(v.size() == 70);
+    REQUIRE(v == lsh::vector::random(70, h));
+    REQUIRE(lsh::vector_view(v).data()[1] >> 6 == 0);
+  }
+}
@@ -0,0 +1,54 @@
+// Copyright (c) 2016 Kasper Kronborg Isager and Radosław Niemczyk.
+#include <test.hpp>
+#include <hemingway/vector.hpp>
+#include <hemingway/vector_view.hpp>
+
+lsh::kernel::word ws[] = {0x8000000000000001, 0x9};
+
+lsh::vector_view v(ws, 68);
+
+TEST_CASE("#size returns the number of components in a view") {
+  REQUIRE(v.size() == 68);
+  REQUIRE(v.chunks() == 2);
+}
+
+TEST_CASE("#data returns the words of a view without copying them") {
+  REQUIRE(v.data() == ws);
+}
+
+TEST_CASE("#get returns the component at a specified index of a view") {
+  for (unsigned int i = 0; i < 68; i++) {
+    bool c = i == 0 || i == 63 || i == 64 || i == 67;
+
+    REQUIRE(v.get(i) == c);
+  }
+
+  REQUIRE_THROWS_AS(v.get(68), std::out_of_range);
+}
+
+TEST_CASE("Views of a vector share its components") {
+  lsh::vector u({1, 0, 0, 1});
+
+  lsh::vector_view w = u;
+
+  REQUIRE(w.size() == 4);
+  REQUIRE(w.get(0) == 1);
+  REQUIRE(w.get(1) == 0);
+  REQUIRE(w.hash() == u.hash());
+  REQUIRE(lsh::vector(w) == u);
+}
+
+TEST_CASE("#& computes the bitwise AND of two views") {
+  lsh::kernel::word us[] = {0x8000000000000000, 0xf};
+
+  lsh::vector_view u(us, 68);
+
+  REQUIRE((v & u).to_string() == "Vector[1" + std::string(63, '0') + "1001]");
+}
+
+TEST_CASE(".distance accepts views") {
+  lsh::kernel::word us[] = {0, 0};
+
+  REQUIRE(lsh::vector::distance(v, lsh::vector_view(us, 68)) == 4);
+  REQUIRE(lsh::vector::distance(v, lsh::vector(ws, 68)) == 0);
+}